@@ -20,36 +20,251 @@
 #include "BdMatrix.h"
 #include "EigenSolver.h"
 #include "ExEigenSolver.h"
+#include "Parallel.h"
 
 #include <stdexcept>
 #include <Eigen/Dense>
 
 namespace lfa {
 
+namespace {
+
+    /** Report a block that cannot be inverted. */
+    void throw_not_invertible(int block_rows, int block_cols,
+                              int failed_block, int failed_rank)
+    {
+        stringstream msg;
+        msg << "Matrix is not invertible "
+            << "(up to machine precision). "
+            << "Failed to invert "
+            << block_rows << "x" << block_cols
+            << " block "
+            << failed_block << "." << endl
+            << "Its numerical rank is "
+            << failed_rank
+            << "." << endl;
+
+        throw runtime_error(msg.str());
+    }
+
+    /** A pivot below this fraction of the largest one is considered zero,
+     * the threshold of FullPivLU. */
+    double pivot_threshold(int size)
+    {
+        return NumTraits<double>::epsilon() * size;
+    }
+
+    /** The number of diagonal entries that are not negligible. */
+    template <typename Diag>
+    int diagonal_rank(const Diag& d)
+    {
+        double max = d.cwiseAbs().maxCoeff();
+        return (d.cwiseAbs().array() > pivot_threshold(d.size()) * max)
+            .count();
+    }
+
+    complex<double> integer_power(complex<double> z, int p)
+    {
+        complex<double> result = 1;
+        for (; p > 0; p >>= 1) {
+            if (p & 1)
+                result *= z;
+            z *= z;
+        }
+        return result;
+    }
+
+    /** Copy a block into a matrix of the arithmetic that is used for it.
+     * A real matrix receives the real parts. */
+    void load_block(MatrixXcd& m, BdMatrix::ConstBlockRef b) { m = b; }
+    void load_block(MatrixXd& m, BdMatrix::ConstBlockRef b) { m = b.real(); }
+
+    /** Add c times the identity. A real matrix only receives the real
+     * part of c. */
+    void add_to_diagonal(MatrixXcd& m, complex<double> c)
+    {
+        m.diagonal().array() += c;
+    }
+    void add_to_diagonal(MatrixXd& m, complex<double> c)
+    {
+        m.diagonal().array() += c.real();
+    }
+
+    /** Store the p-th power (p > 0) of base in result, using repeated
+     * squaring. The base is overwritten. */
+    template <typename Matrix>
+    void repeated_squaring(Matrix& base, int p, Matrix& result, Matrix& tmp)
+    {
+        bool first = true;
+        for (; p > 0; p >>= 1) {
+            if (p & 1) {
+                if (first) {
+                    result = base;
+                    first = false;
+                } else {
+                    tmp.noalias() = result * base;
+                    result.swap(tmp);
+                }
+            }
+            if (p > 1) {
+                tmp.noalias() = base * base;
+                base.swap(tmp);
+            }
+        }
+    }
+
+    /** Store sum_k coefficients[k] * b^k in acc, using the Horner
+     * scheme. */
+    template <typename Matrix>
+    void horner(const Matrix& b,
+                const vector<complex<double> >& coefficients,
+                Matrix& acc, Matrix& tmp)
+    {
+        int n = coefficients.size();
+
+        // acc = c_{n-1}, then acc = acc * B + c_k
+        acc.setZero(b.rows(), b.cols());
+        add_to_diagonal(acc, coefficients[n-1]);
+        for (int k = n-2; k >= 0; --k) {
+            tmp.noalias() = acc * b;
+            add_to_diagonal(tmp, coefficients[k]);
+            acc.swap(tmp);
+        }
+    }
+
+    bool is_real(const vector<complex<double> >& values)
+    {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (imag(values[i]) != 0.0)
+                return false;
+        }
+        return true;
+    }
+
+    /** Invert every block of a dense matrix in the arithmetic of Matrix.
+     * Returns the first block that is not invertible and stores its rank
+     * in failed_rank. Returns the number of blocks if all blocks are
+     * invertible. */
+    template <typename Matrix>
+    int invert_blocks(const BdMatrix& m, BdMatrix& result, int& failed_rank)
+    {
+        int failed_block = m.no_blocks();
+        // the caller sets the structure of the result
+        complex<double>* out = result.data();
+
+        #pragma omp parallel
+        {
+            Matrix b;
+
+            #pragma omp for
+            for (int i = 0; i < m.no_blocks(); ++i) {
+                load_block(b, m.block(i));
+
+                FullPivLU<Matrix> lu(b);
+                if (!lu.isInvertible()) {
+                    #pragma omp critical(lfa_bdmatrix_inverse)
+                    {
+                        if (i < failed_block) {
+                            failed_block = i;
+                            failed_rank = lu.rank();
+                        }
+                    }
+                    continue;
+                }
+
+                BdMatrix::BlockRef(out + i * result.block_size(),
+                                   result.block_rows(), result.block_cols())
+                    = lu.inverse().template cast<complex<double> >();
+            }
+        }
+
+        return failed_block;
+    }
+
+    /** Solve with every block of the (square) lhs for the corresponding
+     * block of rhs, in the arithmetic of Matrix. Returns the first block
+     * of lhs that is not invertible, or the number of blocks. */
+    template <typename Matrix>
+    int solve_blocks(const BdMatrix& lhs, const BdMatrix& rhs,
+                     BdMatrix& result)
+    {
+        int failed_block = lhs.no_blocks();
+        double threshold = pivot_threshold(lhs.block_rows());
+        // the caller sets the structure of the result
+        complex<double>* out = result.data();
+
+        #pragma omp parallel
+        {
+            PartialPivLU<Matrix> lu(lhs.block_rows());
+            Matrix a, b;
+
+            #pragma omp for
+            for (int i = 0; i < lhs.no_blocks(); ++i) {
+                load_block(a, lhs.block(i));
+                lu.compute(a);
+
+                double min_pivot =
+                    lu.matrixLU().diagonal().cwiseAbs().minCoeff();
+                double max_pivot =
+                    lu.matrixLU().diagonal().cwiseAbs().maxCoeff();
+                if (min_pivot <= threshold * max_pivot) {
+                    #pragma omp critical(lfa_bdmatrix_inverse)
+                    {
+                        if (i < failed_block)
+                            failed_block = i;
+                    }
+                    continue;
+                }
+
+                load_block(b, rhs.block(i));
+                BdMatrix::BlockRef(out + i * result.block_size(),
+                                   result.block_rows(), result.block_cols())
+                    = lu.solve(b).template cast<complex<double> >();
+            }
+        }
+
+        return failed_block;
+    }
+
+}
+
 BdMatrix::BdMatrix(int no_diag_blocks, int block_rows, int block_cols)
-  : m_block_rows(block_rows),
+  : m_no_blocks(no_diag_blocks),
+    m_block_rows(block_rows),
     m_block_cols(block_cols),
-    m_diag_matrices(no_diag_blocks, MatrixXcd(block_rows, block_cols))
+    m_real(false),
+    m_data(no_diag_blocks * block_rows * block_cols)
 {
     assert(no_diag_blocks >= 0);
+    setStructure(Dense);
 }
 
 void BdMatrix::resize(int no_diag_blocks, int block_rows, int block_cols)
 {
-    m_diag_matrices.resize(no_diag_blocks);
-    fill(m_diag_matrices.begin(),
-         m_diag_matrices.end(),
-         MatrixXcd(block_rows, block_cols));
+    assert(no_diag_blocks >= 0);
 
+    m_no_blocks = no_diag_blocks;
     m_block_rows = block_rows;
     m_block_cols = block_cols;
+
+    m_data.resize(no_diag_blocks * block_rows * block_cols);
+    forgetStructure();
 }
 
 void BdMatrix::setZero()
 {
-    for (int i = 0; i < no_blocks(); ++i) {
-        set_block(i, MatrixXcd::Zero(m_block_rows, m_block_cols));
-    }
+    m_data.setZero();
+    m_structure = Zero;
+}
+
+void BdMatrix::setStructure(Structure structure)
+{
+    assert(structure == Zero || structure == Dense
+           || m_block_rows == m_block_cols);
+
+    if (structure == Dense && m_block_rows == 1 && m_block_cols == 1)
+        structure = Diagonal;
+    m_structure = structure;
 }
 
 MatrixXcd BdMatrix::full() const
@@ -72,12 +287,33 @@ BdMatrix BdMatrix::operator+ (const BdMatrix& rhs) const
     if (!dimensions_match(rhs))
         throw std::logic_error("Dimensions mismatch");
 
+    if (m_structure == Zero)
+        return rhs;
+    if (rhs.m_structure == Zero)
+        return *this;
+
     BdMatrix result(no_blocks(), m_block_rows, m_block_cols);
 
+    if (isDiagonal() && rhs.isDiagonal()) {
+        result.setZero();
+
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).diagonal() = block(i).diagonal()
+                                         + rhs.block(i).diagonal();
+        }
+
+        result.setStructure(Diagonal);
+        result.m_real = m_real && rhs.m_real;
+        return result;
+    }
+
+    #pragma omp parallel for
     for (int i = 0; i < no_blocks(); ++i) {
-        result.set_block(i, block(i) + rhs.block(i));
+        result.raw_block(i) = block(i) + rhs.block(i);
     }
 
+    result.m_real = m_real && rhs.m_real;
     return result;
 }
 
@@ -87,22 +323,82 @@ BdMatrix BdMatrix::operator* (const BdMatrix& rhs) const
             m_block_cols != rhs.m_block_rows)
         throw std::logic_error("Dimensions mismatch");
 
+    if (m_structure == Identity)
+        return rhs;
+    if (rhs.m_structure == Identity)
+        return *this;
+
     BdMatrix result(no_blocks(), m_block_rows, rhs.m_block_cols);
 
-    for (int i = 0; i < no_blocks(); ++i) {
-        result.set_block(i, block(i) * rhs.block(i));
+    if (m_structure == Zero || rhs.m_structure == Zero) {
+        result.setZero();
+        return result;
     }
 
+    // Scaling the rows or the columns is enough, if a factor is diagonal.
+    if (isDiagonal() && rhs.isDiagonal()) {
+        result.setZero();
+
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).diagonal() = block(i).diagonal().cwiseProduct(
+                                            rhs.block(i).diagonal());
+        }
+
+        result.setStructure(Diagonal);
+    }
+    else if (isDiagonal()) {
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).noalias() = block(i).diagonal().asDiagonal()
+                                        * rhs.block(i);
+        }
+    }
+    else if (rhs.isDiagonal()) {
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).noalias() = block(i)
+                                      * rhs.block(i).diagonal().asDiagonal();
+        }
+    }
+    else if (m_real && rhs.m_real) {
+        #pragma omp parallel
+        {
+            // reused for all blocks of a thread
+            MatrixXd a, b, c;
+
+            #pragma omp for
+            for (int i = 0; i < no_blocks(); ++i) {
+                load_block(a, block(i));
+                load_block(b, rhs.block(i));
+                c.noalias() = a * b;
+                result.raw_block(i) = c.cast<complex<double> >();
+            }
+        }
+    }
+    else {
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).noalias() = block(i) * rhs.block(i);
+        }
+    }
+
+    result.m_real = m_real && rhs.m_real;
     return result;
 }
 
 BdMatrix operator* (complex<double> scalar, const BdMatrix& mat)
 {
     BdMatrix result(mat.no_blocks(), mat.m_block_rows, mat.m_block_cols);
+    result.m_data = scalar * mat.m_data;
 
-    for (int i = 0; i < mat.no_blocks(); ++i) {
-        result.set_block(i, scalar * mat.block(i));
-    }
+    if (scalar == 0.0)
+        result.setStructure(BdMatrix::Zero);
+    else if (mat.m_structure == BdMatrix::Identity && scalar != 1.0)
+        result.setStructure(BdMatrix::Diagonal);
+    else
+        result.setStructure(mat.m_structure);
+    result.m_real = scalar == 0.0 || (mat.m_real && imag(scalar) == 0.0);
 
     return result;
 }
@@ -114,32 +410,204 @@ bool BdMatrix::dimensions_match(const BdMatrix& rhs) const
             && (no_blocks() == rhs.no_blocks());
 }
 
+BdMatrix BdMatrix::power(int p) const
+{
+    if (m_block_rows != m_block_cols)
+        throw std::logic_error("Only square blocks have powers.");
+    if (p < 0)
+        throw std::logic_error("The exponent must not be negative.");
+
+    if (m_structure == Identity || (m_structure == Zero && p > 0))
+        return *this;
+
+    BdMatrix result(no_blocks(), m_block_rows, m_block_cols);
+
+    if (isDiagonal()) {
+        result.setZero();
+
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            for (int j = 0; j < m_block_rows; ++j) {
+                result.raw_entry(i, j, j) = integer_power((*this)(i, j, j), p);
+            }
+        }
+
+        result.setStructure(p == 0 ? Identity : Diagonal);
+        result.m_real = m_real || p == 0;
+        return result;
+    }
+
+    if (p == 0) {
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.raw_block(i).setIdentity();
+        }
+
+        result.setStructure(Identity);
+        result.m_real = true;
+        return result;
+    }
+
+    #pragma omp parallel
+    {
+        // reused for all blocks of a thread
+        MatrixXcd base, acc, tmp;
+        MatrixXd real_base, real_acc, real_tmp;
+
+        #pragma omp for
+        for (int i = 0; i < no_blocks(); ++i) {
+            if (m_real) {
+                load_block(real_base, block(i));
+                repeated_squaring(real_base, p, real_acc, real_tmp);
+                result.raw_block(i) = real_acc.cast<complex<double> >();
+            } else {
+                load_block(base, block(i));
+                repeated_squaring(base, p, acc, tmp);
+                result.raw_block(i) = acc;
+            }
+        }
+    }
+
+    result.m_real = m_real;
+    return result;
+}
+
+BdMatrix BdMatrix::polynomial(const vector<complex<double> >& coefficients)
+    const
+{
+    if (m_block_rows != m_block_cols)
+        throw std::logic_error("Only square blocks have polynomials.");
+
+    BdMatrix result(no_blocks(), m_block_rows, m_block_cols);
+    int n = coefficients.size();
+    if (n == 0) {
+        result.setZero();
+        return result;
+    }
+
+    if (isDiagonal()) {
+        result.setZero();
+
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            for (int j = 0; j < m_block_rows; ++j) {
+                complex<double> x = (*this)(i, j, j);
+                complex<double> acc = coefficients[n-1];
+                for (int k = n-2; k >= 0; --k) {
+                    acc = acc * x + coefficients[k];
+                }
+                result.raw_entry(i, j, j) = acc;
+            }
+        }
+
+        result.setStructure(Diagonal);
+        result.m_real = m_real && is_real(coefficients);
+        return result;
+    }
+
+    bool real = m_real && is_real(coefficients);
+
+    #pragma omp parallel
+    {
+        MatrixXcd b, acc, tmp;
+        MatrixXd real_b, real_acc, real_tmp;
+
+        #pragma omp for
+        for (int i = 0; i < no_blocks(); ++i) {
+            if (real) {
+                load_block(real_b, block(i));
+                horner(real_b, coefficients, real_acc, real_tmp);
+                result.raw_block(i) = real_acc.cast<complex<double> >();
+            } else {
+                load_block(b, block(i));
+                horner(b, coefficients, acc, tmp);
+                result.raw_block(i) = acc;
+            }
+        }
+    }
+
+    result.m_real = real;
+    return result;
+}
+
 BdMatrix BdMatrix::inverse() const
 {
     assert(m_block_rows == m_block_rows);
-    BdMatrix result(no_blocks(), m_block_rows, m_block_cols);
 
-    for (int i = 0; i < no_blocks(); ++i) {
+    if (m_structure == Identity)
+        return *this;
+    if (m_structure == Zero)
+        throw_not_invertible(m_block_rows, m_block_cols, 0, 0);
 
-        FullPivLU<MatrixXcd> lu(block(i));
-        if (!lu.isInvertible()) {
-            stringstream msg;
-            msg << "Matrix is not invertible "
-                << "(up to machine precision). "
-                << "Failed to invert "
-                << m_block_rows << "x" << m_block_cols
-                << " block "
-                << i << "." << endl
-                << "Its numerical rank is "
-                << lu.rank()
-                << "." << endl;
+    BdMatrix result(no_blocks(), m_block_rows, m_block_cols);
 
-            throw runtime_error(msg.str());
+    // the first block that could not be inverted
+    int failed_block = no_blocks();
+    int failed_rank = 0;
+
+    if (isDiagonal()) {
+        result.setZero();
+
+        #pragma omp parallel for
+        for (int i = 0; i < no_blocks(); ++i) {
+            ConstBlockRef b = block(i);
+            int rank = diagonal_rank(b.diagonal());
+            if (rank < m_block_rows) {
+                #pragma omp critical(lfa_bdmatrix_inverse)
+                {
+                    if (i < failed_block) {
+                        failed_block = i;
+                        failed_rank = rank;
+                    }
+                }
+                continue;
+            }
+
+            result.raw_block(i).diagonal() = b.diagonal().cwiseInverse();
         }
 
-        result.set_block(i, lu.inverse());
+        result.setStructure(Diagonal);
+    }
+    else if (m_real) {
+        failed_block = invert_blocks<MatrixXd>(*this, result, failed_rank);
     }
+    else {
+        failed_block = invert_blocks<MatrixXcd>(*this, result, failed_rank);
+    }
+
+    if (failed_block < no_blocks())
+        throw_not_invertible(m_block_rows, m_block_cols,
+                             failed_block, failed_rank);
 
+    result.m_real = m_real;
+    return result;
+}
+
+BdMatrix BdMatrix::solve(const BdMatrix& rhs) const
+{
+    if (m_block_rows != m_block_cols)
+        throw std::logic_error("Only square blocks can be inverted.");
+    if (no_blocks() != rhs.no_blocks() || m_block_cols != rhs.m_block_rows)
+        throw std::logic_error("Dimensions mismatch");
+
+    // a diagonal matrix is inverted directly
+    if (isDiagonal())
+        return inverse() * rhs;
+
+    BdMatrix result(no_blocks(), m_block_rows, rhs.m_block_cols);
+    bool real = m_real && rhs.m_real;
+
+    // the first block that could not be inverted
+    int failed_block = real ? solve_blocks<MatrixXd>(*this, rhs, result)
+                            : solve_blocks<MatrixXcd>(*this, rhs, result);
+
+    if (failed_block < no_blocks()) {
+        // only computed for the report
+        throw_not_invertible(m_block_rows, m_block_cols, failed_block,
+                FullPivLU<MatrixXcd>(block(failed_block)).rank());
+    }
+
+    result.m_real = real;
     return result;
 }
 
@@ -147,21 +615,19 @@ BdMatrix BdMatrix::adjoint() const
 {
     BdMatrix result(no_blocks(), m_block_cols, m_block_rows);
 
+    #pragma omp parallel for
     for (int i = 0; i < no_blocks(); ++i) {
-        result.set_block(i, block(i).adjoint());
+        result.raw_block(i) = block(i).adjoint();
     }
 
+    result.setStructure(m_structure);
+    result.m_real = m_real;
     return result;
 }
 
 double BdMatrix::squaredNorm() const
 {
-    double sq_norm = 0;
-    for (int i = 0; i < no_blocks(); ++i) {
-        sq_norm += block(i).squaredNorm();
-    }
-
-    return sq_norm;
+    return m_data.squaredNorm();
 }
 
 double BdMatrix::norm() const
@@ -171,44 +637,119 @@ double BdMatrix::norm() const
 
 double BdMatrix::spectral_radius() const
 {
-    vector<double> radii(no_blocks());
-    for (int i = 0; i < no_blocks(); ++i) {
-        radii[i] = abs(eigenvalue_max_magnitude(block(i)));
+    // the eigenvalues of a diagonal block are its diagonal
+    if (isDiagonal())
+        return diagonal_magnitude();
+
+    double radius = 0;
+    ParallelErrors errors;
+
+    // All blocks have the same size. Hence, every thread uses a single
+    // solver and the work arrays are only allocated once per thread.
+    #pragma omp parallel reduction(max:radius)
+    {
+        EigenvalueSolver solver;
+        MatrixXd b;
+        VectorXcd eigs(m_block_rows);
+
+        #pragma omp for
+        for (int i = 0; i < no_blocks(); ++i) {
+            try {
+                if (m_real) {
+                    load_block(b, block(i));
+                    solver.realEigenvalues(b, eigs);
+                    radius = std::max(radius, eigs.cwiseAbs().maxCoeff());
+                } else {
+                    radius = std::max(radius,
+                            abs(eigenvalue_max_magnitude(block(i), solver)));
+                }
+            } catch (...) {
+                errors.capture();
+            }
+        }
     }
+    errors.rethrow();
 
-    return *std::max_element(radii.begin(), radii.end());
+    return radius;
 }
 
 double BdMatrix::spectral_norm() const
 {
-    vector<double> norms(no_blocks());
+    if (isDiagonal())
+        return diagonal_magnitude();
+
+    double norm = 0;
+    ParallelErrors errors;
+
+    #pragma omp parallel for reduction(max:norm)
     for (int i = 0; i < no_blocks(); ++i) {
-        // compute the singular values
-        norms[i] = sqrt(abs(eigenvalue_max_magnitude(
-                    block(i).adjoint() * block(i))));
+        try {
+            norm = std::max(norm, singular_value_max(block(i)));
+        } catch (...) {
+            errors.capture();
+        }
     }
+    errors.rethrow();
 
-    return *std::max_element(norms.begin(), norms.end());
+    return norm;
 }
 
 VectorXcd BdMatrix::eigenvalues() const
 {
     VectorXcd result(rows());
-    int p = 0;
-    for (int i = 0; i < no_blocks(); ++i) {
-        // compute the eigenvalues of the block
-        VectorXcd block_ews = lfa::eigenvalues(block(i));
 
-        // add them to the vector of all eigenvalues
-        for (int k = 0; k < block_rows(); ++k) {
-            result(p) = block_ews(k);
-            ++p;
+    if (isDiagonal()) {
+        for (int i = 0; i < no_blocks(); ++i) {
+            result.segment(i * block_rows(), block_rows())
+                = block(i).diagonal();
         }
+        return result;
     }
 
+    ParallelErrors errors;
+
+    // Every block contributes block_rows() eigenvalues. Hence, the
+    // eigenvalues of the i-th block start at the offset i * block_rows().
+    #pragma omp parallel
+    {
+        EigenvalueSolver solver;
+        MatrixXd b;
+
+        #pragma omp for
+        for (int i = 0; i < no_blocks(); ++i) {
+            try {
+                // compute the eigenvalues of the block
+                if (m_real) {
+                    load_block(b, block(i));
+                    solver.realEigenvalues(b,
+                        result.segment(i * block_rows(), block_rows()));
+                } else {
+                    solver.eigenvalues(block(i),
+                        result.segment(i * block_rows(), block_rows()));
+                }
+            } catch (...) {
+                errors.capture();
+            }
+        }
+    }
+    errors.rethrow();
+
     return result;
 }
 
+double BdMatrix::diagonal_magnitude() const
+{
+    double magnitude = 0;
+
+    #pragma omp parallel for reduction(max:magnitude)
+    for (int i = 0; i < no_blocks(); ++i) {
+        magnitude = std::max(magnitude,
+                             block(i).diagonal().cwiseAbs().maxCoeff());
+    }
+
+    return magnitude;
+}
+
 ostream& operator<< (ostream& os, const BdMatrix& m)
 {
     for (int i = 0; i < m.no_blocks(); ++i) {
@@ -24,32 +24,118 @@
 
 namespace lfa {
 
-/** Block diagonal matrix storage. */
+/** Block diagonal matrix storage.
+ *
+ * All diagonal blocks are stored in a single contiguous buffer. The blocks
+ * are stored one after another (block-major), each of them in column-major
+ * order, such that the b-th block starts at offset b * block_size().
+ *
+ * The matrix carries a structure tag (see structure()), which the
+ * arithmetic, the inverse and the eigenvalue routines use to skip work.
+ * The storage always holds all entries. Every non-const accessor drops
+ * the tag (see forgetStructure), hence, a writer that knows the structure
+ * of the written entries has to call setStructure afterwards. Readers use
+ * the const accessors, which keep the tag.
+ *
+ * Similarly, a matrix can be marked as real (see isReal()). The products,
+ * the inverse, the solve and the eigenvalues of real matrices are computed
+ * in real arithmetic (e.g., dgeev instead of zgeev). The flag only selects
+ * these kernels: the entries are still stored as complex numbers, hence,
+ * a real matrix uses as much memory as a complex one. Like the structure
+ * tag, the flag has to be set by the writer; a new matrix is not real.
+ */
 class BdMatrix {
 
   public:
+    /** The structure that all blocks share. The Identity and the Diagonal
+     * structure require square blocks. */
+    enum Structure {
+      /** All entries are zero. */
+      Zero,
+      /** Every block is the identity. */
+      Identity,
+      /** Only the diagonals of the blocks are nonzero. */
+      Diagonal,
+      /** No known structure. */
+      Dense
+    };
+
+    /** A view to a single block of the storage. */
+    typedef Map<MatrixXcd, Aligned16> BlockRef;
+    typedef Map<const MatrixXcd, Aligned16> ConstBlockRef;
+
     BdMatrix(int no_diag_blocks = 0, int block_rows = 0, int block_cols = 0);
 
     /** WARNING: Destroys all stored entries. */
     void resize(int no_diag_blocks = 0, int block_rows = 0, int block_cols = 0);
     void setZero();
 
+    Structure structure() const { return m_structure; }
+    /** Declare the structure of the stored entries. Dense is replaced by
+     * Diagonal for 1x1 blocks. */
+    void setStructure(Structure structure);
+    /** Are all blocks diagonal (this includes Zero and Identity)? */
+    bool isDiagonal() const { return m_structure != Dense; }
+
+    /** Are the imaginary parts of all entries zero? */
+    bool isReal() const { return m_real; }
+    /** Declare that the imaginary parts of all entries are zero. */
+    void setReal(bool real) { m_real = real; }
+
+    /** Drop the structure tag and the real flag, i.e., declare that the
+     * entries are arbitrary. */
+    void forgetStructure() {
+      m_structure = (m_block_rows == 1 && m_block_cols == 1) ? Diagonal
+                                                             : Dense;
+      m_real = false;
+    }
+
     /** Acesse the entry (i, j) of the b-th block. */
     complex<double>& operator() (int b, int i, int j) {
-      return m_diag_matrices[b](i, j);
+      forgetStructure();
+      return raw_entry(b, i, j);
+    }
+    complex<double> operator() (int b, int i, int j) const {
+      return m_data[index(b, i, j)];
     }
 
-    const MatrixXcd& block(int i) const { return m_diag_matrices[i]; }
+    BlockRef block(int i) {
+      forgetStructure();
+      return raw_block(i);
+    }
+    ConstBlockRef block(int i) const {
+      assert(0 <= i && i < m_no_blocks);
+      return ConstBlockRef(block_data(i), m_block_rows, m_block_cols);
+    }
     void set_block(int i, const MatrixXcd& v) {
       assert(v.rows() == m_block_rows);
       assert(v.cols() == m_block_cols);
 
-      m_diag_matrices[i] = v;
+      block(i) = v;
+    }
+
+    /** Pointer to the first entry of the i-th block. */
+    complex<double>* block_data(int i) {
+      forgetStructure();
+      return m_data.data() + i * block_size();
+    }
+    const complex<double>* block_data(int i) const {
+      return m_data.data() + i * block_size();
+    }
+
+    /** The storage of all blocks. */
+    complex<double>* data() {
+      forgetStructure();
+      return m_data.data();
     }
+    const complex<double>* data() const { return m_data.data(); }
 
     MatrixXcd full() const;
 
-    int no_blocks() const { return m_diag_matrices.size(); }
+    int no_blocks() const { return m_no_blocks; }
+    /** The number of entries of a single block, i.e., the stride between two
+     * consecutive blocks in the storage. */
+    int block_size() const { return m_block_rows * m_block_cols; }
     int rows() const { return m_block_rows * no_blocks(); }
     int cols() const { return m_block_cols * no_blocks(); }
     int block_rows() const { return m_block_rows; }
@@ -64,6 +150,18 @@ class BdMatrix {
     BdMatrix inverse() const;
     BdMatrix adjoint() const;
 
+    /** The product inverse() * rhs, computed by solving with the LU
+     * decomposition of every block instead of forming the inverse. */
+    BdMatrix solve(const BdMatrix& rhs) const;
+
+    /** The p-th power of every (square) block, computed by repeated
+     * squaring. The zeroth power is the identity. */
+    BdMatrix power(int p) const;
+
+    /** The polynomial sum_k coefficients[k] * B^k of every (square) block
+     * B, evaluated by the Horner scheme. */
+    BdMatrix polynomial(const vector<complex<double> >& coefficients) const;
+
     double squaredNorm() const;
     double norm() const;
 
@@ -72,10 +170,36 @@ class BdMatrix {
 
     VectorXcd eigenvalues() const;
   private:
+    int index(int b, int i, int j) const {
+      assert(0 <= b && b < m_no_blocks);
+      assert(0 <= i && i < m_block_rows);
+      assert(0 <= j && j < m_block_cols);
+
+      return b * block_size() + j * m_block_rows + i;
+    }
+
+    /** Write access that keeps the structure tag, for the arithmetic,
+     * which sets the tag of its results itself. */
+    complex<double>& raw_entry(int b, int i, int j) {
+      return m_data[index(b, i, j)];
+    }
+    BlockRef raw_block(int i) {
+      assert(0 <= i && i < m_no_blocks);
+      return BlockRef(m_data.data() + i * block_size(),
+                      m_block_rows, m_block_cols);
+    }
+
+    /** The largest magnitude of the diagonal entries. */
+    double diagonal_magnitude() const;
+
+    int m_no_blocks;
     int m_block_rows;
     int m_block_cols;
+    Structure m_structure;
+    bool m_real;
 
-    vector<MatrixXcd> m_diag_matrices;
+    /** The entries of all blocks. */
+    VectorXcd m_data;
 };
 
 ostream& operator<< (ostream& os, const BdMatrix& m);
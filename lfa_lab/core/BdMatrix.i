@@ -25,7 +25,7 @@ class BdMatrix {
   public:
     MatrixXcd full() const;
 
-    MatrixXcd block(int i);
+    MatrixXcd block(int i) const;
 
     int no_blocks() const;
     int rows() const;
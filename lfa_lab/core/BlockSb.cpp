@@ -20,6 +20,10 @@
 #include "BlockSb.h"
 #include "DiscreteDomain.h"
 #include "MathUtil.h"
+#include "Hash.h"
+#include "Fft.h"
+
+#include <typeinfo>
 
 namespace lfa {
 
@@ -28,6 +32,11 @@ BlockSb::BlockSb(Grid grid, ArrayFi period)
 {
 }
 
+BlockSb::BlockSb(Grid grid, NdArray<SymbolBuilderPtr> scalars)
+  : m_grid(grid), m_period(scalars.shape()), m_scalar_builders(scalars)
+{
+}
+
 void BlockSb::scalarSymbols(NdArray<Symbol> scalars)
 {
     if ((scalars.shape() != m_period).any()) {
@@ -59,55 +68,149 @@ FoProperties BlockSb::scalar_properties()
 
 Symbol BlockSb::generate(const SamplingProperties& conf)
 {
+    if (hasScalarBuilders()) {
+        return generateFromDependencies(conf);
+    } else {
+        return combineScalars(conf, m_scalars);
+    }
+}
+
+vector<SymbolBuilderPtr> BlockSb::dependencies()
+{
+    vector<SymbolBuilderPtr> deps;
+
+    if (hasScalarBuilders()) {
+        NdRange indices = m_scalar_builders.indices();
+        for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p) {
+            deps.push_back(m_scalar_builders(*p));
+        }
+    }
+
+    return deps;
+}
+
+Symbol BlockSb::combine(const SamplingProperties& conf,
+                        const vector<Symbol>& symbols)
+{
+    if (!hasScalarBuilders())
+        return SymbolBuilder::combine(conf, symbols);
+
+    // the symbols are given in the order of dependencies()
+    NdArray<Symbol> scalars(m_period);
+    NdRange indices = scalars.indices();
+    size_t k = 0;
+    for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p) {
+        scalars(*p) = symbols.at(k++);
+    }
+
+    return combineScalars(conf, scalars);
+}
+
+size_t BlockSb::hash()
+{
+    // precomputed scalar symbols are not compared
+    if (!hasScalarBuilders())
+        return SymbolBuilder::hash();
+
+    size_t seed = typeid(BlockSb).hash_code();
+    hash_combine(seed, hash_value(m_grid));
+    hash_combine(seed, hash_value(m_period));
+    return seed;
+}
+
+bool BlockSb::equals(SymbolBuilder& other)
+{
+    BlockSb* o = dynamic_cast<BlockSb*>(&other);
+    if (!o || !hasScalarBuilders() || !o->hasScalarBuilders())
+        return SymbolBuilder::equals(other);
+
+    return identical(m_grid, o->m_grid)
+        && (m_period == o->m_period).all();
+}
+
+Symbol BlockSb::combineScalars(const SamplingProperties& conf,
+                               const NdArray<Symbol>& scalars)
+{
+    if (scalars.dimension() != m_period.rows()
+            || (scalars.shape() != m_period).any()) {
+        throw logic_error("Invalid number of scalars.");
+    }
+
     DiscreteDomain scalar_dd(scalar_domain(), conf);
 
     // we need to ensure that all symbols have the same properties
-    NdRange indices = m_scalars.indices();
+    NdRange indices = scalars.indices();
     for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p) {
-        if (m_scalars(*p).inputClusters() != scalar_dd.harmonics()
-                || m_scalars(*p).outputClusters() != scalar_dd.harmonics())
+        if (scalars(*p).inputClusters() != scalar_dd.harmonics()
+                || scalars(*p).outputClusters() != scalar_dd.harmonics())
         {
             throw logic_error("Symbol has the wrong coupling.");
         }
     }
 
 
-    // do the computation
+    // With the Fourier matrix F(i,j) = exp(2 pi i (i.j / period)), the
+    // symbol of a cluster is 1/n F^H G, where G(i,j) = s_i(g_j) F(i,j), s_i
+    // is the symbol of the i-th scalar operator, and g_j the global index
+    // of the j-th frequency of the cluster. Thus, the entry (r, j) is the
+    // DFT of s_.(g_j) at (r - j) mod period, divided by n.
     DiscreteDomain domain(properties().output(), conf);
-
-    ArrayFi zero = ArrayFi::Zero(dimension());
     HarmonicClusters clusters = domain.harmonics();
 
-    NdRange base_grid = clusters.baseIndices();
     NdRange cluster_grid = clusters.clusterIndices();
+    int n = cluster_grid.size();
+    ArrayFi period = clusters.clusterShape();
 
-    Symbol F(clusters, clusters);
-    Symbol G(clusters, clusters);
+    vector<const complex<double>*> scalar_data(n);
+    for (int i = 0; i < n; ++i) {
+        scalar_data[i] = scalars(cluster_grid.coordOf(i)).matrix().data();
+    }
 
-    for (NdRange::iterator b = base_grid.begin(); b != base_grid.end(); ++b)
-    {
-        for (NdRange::iterator i = cluster_grid.begin();
-                i != cluster_grid.end(); ++i)
-        {
-            for (NdRange::iterator j = cluster_grid.begin();
-                    j != cluster_grid.end(); ++j)
-            {
-                ArrayFi gj = clusters.globalIndex(*b, *j);
-
-                double arg = 2 * pi *
-                             (i->cast<double>() *
-                              j->cast<double>() /
-                              clusters.clusterShape().cast<double>())
-                             .sum();
-                F.ref(*b, *i, *j) = exp(complex<double>(0, arg));
-                G.ref(*b, *i, *j) = m_scalars(*i).ref(gj,zero,zero)
-                                    * F.ref(*b, *i, *j);
+    // the linear global indices, which are the base indices of the
+    // scalar symbols, and the position of (r - j) mod period
+    HarmonicIndexTable table = clusters.indexTable();
+    vector<int> difference(n * n);
+    for (int j = 0; j < n; ++j) {
+        ArrayFi cj = cluster_grid.coordOf(j);
+
+        for (int r = 0; r < n; ++r) {
+            ArrayFi diff = cluster_grid.coordOf(r) - cj + period;
+            diff = diff.binaryExpr(period, std::modulus<int>());
+            difference[r + n * j] = cluster_grid.indexOf(diff);
+        }
+    }
 
+    FftNd fft(period, -1);
+    Symbol result(clusters, clusters);
+    // obtained once, since writing through the accessors of the matrix
+    // would update its structure tag from every thread
+    complex<double>* data = result.matrix().data();
+    int no_bases = table.baseSize();
+
+    #pragma omp parallel
+    {
+        vector<complex<double> > values(n);
+
+        #pragma omp for
+        for (int ib = 0; ib < no_bases; ++ib) {
+            for (int j = 0; j < n; ++j) {
+                int g = table.global(ib, j);
+                for (int i = 0; i < n; ++i) {
+                    values[i] = scalar_data[i][g];
+                }
+
+                fft.transform(values.data());
+
+                // the n x n block of ib, column-major
+                complex<double>* column = data + (ib * n + j) * n;
+                for (int r = 0; r < n; ++r) {
+                    column[r] = values[difference[r + n * j]] / double(n);
+                }
             }
         }
     }
 
-    return (1.0 / clusters.clusterSize()) * F.adjoint() * G;
+    return result;
 }
 
 
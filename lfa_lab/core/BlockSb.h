@@ -36,6 +36,10 @@ namespace lfa {
     public:
       BlockSb(Grid grid, ArrayFi period);
 
+      /** Combine the symbols generated by the given scalar builders. The
+       * period is the shape of the array. */
+      BlockSb(Grid grid, NdArray<SymbolBuilderPtr> scalars);
+
       /** Set the scalar symbols that should be combined. */
       void scalarSymbols(NdArray<Symbol> scalars);
 
@@ -50,11 +54,35 @@ namespace lfa {
 
       Symbol generate(const SamplingProperties& conf);
 
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
       int dimension() { return m_grid.dimension(); }
+
+      Grid grid() const { return m_grid; }
+
+      /** The builders of the scalar operators. Empty, if the scalar
+       * symbols are set directly. */
+      const NdArray<SymbolBuilderPtr>& scalarBuilders() const {
+        return m_scalar_builders;
+      }
     private:
+      Symbol combineScalars(const SamplingProperties& conf,
+                            const NdArray<Symbol>& scalars);
+
+      /** Are the scalar symbols generated by builders? */
+      bool hasScalarBuilders() const {
+        return m_scalar_builders.dimension() > 0;
+      }
+
       Grid m_grid;
       ArrayFi m_period;
       NdArray<Symbol> m_scalars;
+      NdArray<SymbolBuilderPtr> m_scalar_builders;
   };
 
 
@@ -19,6 +19,9 @@
 
 #include "ConstantSb.h"
 #include "DiscreteDomain.h"
+#include "Hash.h"
+
+#include <typeinfo>
 
 namespace lfa {
 
@@ -42,6 +45,43 @@ FoProperties ConstantSb::properties()
         SplitFrequencyDomain(m_input_grid, m_symbol.inputShape()));
 }
 
+Symbol ConstantSb::generateExpanded(const SamplingProperties& conf,
+                                    ArrayFi factor)
+{
+    FoProperties props = properties().expand(factor);
+    Symbol result(
+            DiscreteDomain(props.output(), conf).harmonics(),
+            DiscreteDomain(props.input(), conf).harmonics());
+
+    // A merged cluster consists of one copy of the cluster symbol per
+    // sub-base r. The cluster index c of such a copy becomes
+    // c * factor + r.
+    ClusterSymbol merged(props.output().clusterShape(),
+                         props.input().clusterShape());
+    merged.setMatrix(MatrixXcd::Zero(merged.rowIndices().size(),
+                                     merged.colIndices().size()));
+    NdRange sub_bases(factor);
+    NdRange rows = m_symbol.rowIndices();
+    NdRange cols = m_symbol.colIndices();
+    for (NdRange::iterator r = sub_bases.begin(); r != sub_bases.end(); ++r)
+    {
+        for (NdRange::iterator i = rows.begin(); i != rows.end(); ++i) {
+            for (NdRange::iterator j = cols.begin(); j != cols.end(); ++j) {
+                merged((*i) * factor + *r, (*j) * factor + *r)
+                    = m_symbol(*i, *j);
+            }
+        }
+    }
+
+    NdRange indices = result.baseIndices();
+    for (NdRange::iterator b = indices.begin(); b != indices.end(); ++b)
+    {
+        result.setCluster(*b, merged);
+    }
+
+    return result;
+}
+
 Symbol ConstantSb::generate(const SamplingProperties& conf)
 {
     Symbol result(
@@ -57,6 +97,38 @@ Symbol ConstantSb::generate(const SamplingProperties& conf)
     return result;
 }
 
+bool ConstantSb::realCoefficients(const SamplingProperties& conf)
+{
+    MatrixXcd m = m_symbol.toMatrix();
+    if (m.size() == 0)
+        return true;
+
+    return (m.array() == m(0, 0)).all() && imag(m(0, 0)) == 0.0;
+}
+
+size_t ConstantSb::hash()
+{
+    size_t seed = typeid(ConstantSb).hash_code();
+    hash_combine(seed, hash_value(m_output_grid));
+    hash_combine(seed, hash_value(m_input_grid));
+    hash_combine(seed, hash_value(m_symbol.toMatrix()));
+    return seed;
+}
+
+bool ConstantSb::equals(SymbolBuilder& other)
+{
+    ConstantSb* o = dynamic_cast<ConstantSb*>(&other);
+    if (!o)
+        return false;
+
+    return identical(m_output_grid, o->m_output_grid)
+        && identical(m_input_grid, o->m_input_grid)
+        && m_symbol.outputShape().rows() == o->m_symbol.outputShape().rows()
+        && (m_symbol.outputShape() == o->m_symbol.outputShape()).all()
+        && (m_symbol.inputShape() == o->m_symbol.inputShape()).all()
+        && m_symbol.toMatrix() == o->m_symbol.toMatrix();
+}
+
 ClusterSymbol flat_restriction_cluster_symbol(Grid output_grid, Grid input_grid)
 {
     ArrayFi factor = input_grid.coarsening_factor(output_grid);
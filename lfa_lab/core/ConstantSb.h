@@ -34,6 +34,15 @@ namespace lfa {
 
       FoProperties properties();
       Symbol generate(const SamplingProperties& conf);
+      Symbol generateExpanded(const SamplingProperties& conf,
+                              ArrayFi factor);
+
+      /** Only a real cluster symbol with equal entries is assumed to be
+       * real, since the negative frequencies permute the harmonics. */
+      bool realCoefficients(const SamplingProperties& conf);
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
     private:
       ClusterSymbol m_symbol;
       Grid m_output_grid;
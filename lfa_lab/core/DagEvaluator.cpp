@@ -0,0 +1,504 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "DagEvaluator.h"
+#include "Hash.h"
+#include "DiscreteDomain.h"
+#include "MathUtil.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace lfa {
+
+  namespace {
+
+    /** The base shape of the symbol of an operator, if its clusters are
+     * not merged. */
+    ArrayFi natural_base(const FoProperties& props,
+                         const SamplingProperties& conf)
+    {
+      return DiscreteDomain(props.output(), conf).harmonics()
+        .baseIndices().shape();
+    }
+
+    /** Can the domain be sampled with the given finest resolution? See
+     * FoProperties::adjustResolution. */
+    bool samples(const SplitFrequencyDomain& domain, const ArrayFi& resolution)
+    {
+      ArrayFi factor = domain.grid().spacing() * domain.clusterShape();
+      return resolution.binaryExpr(factor, std::modulus<int>()).isZero();
+    }
+
+    /** For every cluster index of the cluster of the given base index, the
+     * (linear) cluster index of the negative frequency. The lattice index
+     * g has the negative frequency of -(g + shift), see
+     * SamplingProperties::conjugateShift. */
+    vector<int> conjugate_cluster(const HarmonicClusters& clusters,
+                                  const ArrayFi& base,
+                                  const ArrayFi& shift)
+    {
+      const NdRange indices = clusters.clusterIndices();
+      vector<int> result(indices.size());
+      for (int k = 0; k < indices.size(); ++k) {
+        ArrayFi g = clusters.globalIndex(base, indices.coordOf(k));
+        ArrayFi negative = mod(ArrayFi(-(g + shift)), clusters.shape());
+        result[k] = indices.indexOf(clusters.clusterIndex(negative));
+      }
+      return result;
+    }
+
+    /** The symbol of an operator with real coefficients, given its symbol
+     * for the lattice indices that are even along the dimension dim.
+     *
+     * The shift is odd along dim, hence, the odd lattice indices have the
+     * negative frequencies of even ones. The cluster of an odd base index
+     * is therefore the complex conjugate of the cluster of an even base
+     * index, with the rows and the columns permuted.
+     */
+    Symbol conjugate_complete(const Symbol& half, int dim,
+                              const ArrayFi& shift)
+    {
+      ArrayFi factor = ArrayFi::Ones(shift.rows());
+      factor[dim] = 2;
+      const HarmonicClusters& half_rows = half.outputClusters();
+      const HarmonicClusters& half_cols = half.inputClusters();
+      HarmonicClusters rows(half_rows.baseIndices().shape() * factor,
+                            half_rows.clusterShape());
+      HarmonicClusters cols(half_cols.baseIndices().shape() * factor,
+                            half_cols.clusterShape());
+
+      Symbol result(rows, cols);
+      const NdRange bases = rows.baseIndices();
+      const NdRange half_bases = half.baseIndices();
+      int block_rows = rows.clusterSize();
+      int block_size = block_rows * cols.clusterSize();
+      complex<double>* data = result.matrix().data();
+
+      #pragma omp parallel for
+      for (int i = 0; i < bases.size(); ++i) {
+        ArrayFi base = bases.coordOf(i);
+        complex<double>* out = data + i * block_size;
+
+        if (base[dim] % 2 == 0) {
+          base[dim] /= 2;
+          const complex<double>* in
+            = half.blockData(half_bases.indexOf(base));
+          std::copy(in, in + block_size, out);
+          continue;
+        }
+
+        // the base index of the negative frequencies is even along dim
+        ArrayFi negative = mod(ArrayFi(-(base + shift)), bases.shape());
+        negative[dim] /= 2;
+        const complex<double>* in
+          = half.blockData(half_bases.indexOf(negative));
+
+        vector<int> row = conjugate_cluster(rows, base, shift);
+        vector<int> col = conjugate_cluster(cols, base, shift);
+        for (int c = 0; c < int(col.size()); ++c) {
+          for (int r = 0; r < block_rows; ++r) {
+            out[r + block_rows * c] = conj(in[row[r] + block_rows * col[c]]);
+          }
+        }
+      }
+
+      // conjugation and permutation keep the structure
+      BdMatrix& matrix = result.matrix();
+      matrix.setStructure(half.structure());
+      matrix.setReal(half.isReal());
+
+      return result;
+    }
+
+  }
+
+  DagEvaluator::DagEvaluator(SymbolBuilderPtr root)
+  {
+    if (!root)
+      throw logic_error("Cannot evaluate an empty graph.");
+
+    // the root is the last node
+    std::map<SymbolBuilder*, int> visited;
+    visit(root, visited);
+  }
+
+  int DagEvaluator::visit(SymbolBuilderPtr builder,
+                          std::map<SymbolBuilder*, int>& visited)
+  {
+    std::map<SymbolBuilder*, int>::iterator it = visited.find(builder.get());
+    if (it != visited.end())
+      return it->second;
+
+    Node node;
+    node.builder = builder;
+    node.hash = builder->hash();
+    node.properties = builder->properties();
+
+    // dependencies first
+    vector<SymbolBuilderPtr> deps = builder->dependencies();
+    for (size_t i = 0; i < deps.size(); ++i) {
+      int pos = visit(deps[i], visited);
+      node.dependencies.push_back(pos);
+      hash_combine(node.hash, m_nodes[pos].hash);
+    }
+
+    // merge with a structurally equal node; the dependencies of both have
+    // already been merged
+    typedef std::multimap<size_t, int>::iterator IndexIterator;
+    std::pair<IndexIterator, IndexIterator> range
+      = m_index.equal_range(node.hash);
+    for (IndexIterator i = range.first; i != range.second; ++i) {
+      Node& other = m_nodes[i->second];
+      if (other.dependencies == node.dependencies
+          && builder->equals(*other.builder))
+      {
+        visited[builder.get()] = i->second;
+        return i->second;
+      }
+    }
+
+    m_nodes.push_back(node);
+    int pos = m_nodes.size() - 1;
+    visited[builder.get()] = pos;
+    m_index.insert(std::make_pair(node.hash, pos));
+
+    return pos;
+  }
+
+  vector<ArrayFi>
+  DagEvaluator::expansionFactors(const SamplingProperties& conf) const
+  {
+    int n = m_nodes.size();
+
+    vector<ArrayFi> natural(n);
+    for (int i = 0; i < n; ++i) {
+      natural[i] = natural_base(m_nodes[i].properties, conf);
+    }
+
+    // The base shape every symbol should have. A symbol has to be usable
+    // by all builders that depend on it. Hence, its base shape is the least
+    // common multiple of the base shapes these builders require.
+    vector<ArrayFi> target(n);
+    vector<ArrayFi> factors(n);
+    target[n-1] = natural[n-1];
+    for (int i = n-1; i >= 0; --i) {
+      // all builders that depend on node i come after it
+      ArrayFi rem = natural[i].binaryExpr(target[i], std::modulus<int>());
+      if (!rem.isZero())
+        target[i] = natural[i];
+      factors[i] = natural[i] / target[i];
+
+      const Node& node = m_nodes[i];
+      bool expanded = node.builder->combinesExpanded();
+
+      for (size_t j = 0; j < node.dependencies.size(); ++j) {
+        int d = node.dependencies[j];
+        ArrayFi required = expanded ? target[i] : natural[d];
+
+        if (target[d].rows() == 0)
+          target[d] = required;
+        else
+          target[d] = lcm(target[d], required);
+      }
+    }
+
+    return factors;
+  }
+
+  Symbol DagEvaluator::evaluate(const SamplingProperties& conf,
+                                SymbolCache* cache) const
+  {
+    int dim = conjugateDimension(conf);
+    if (dim < 0)
+      return evaluateAll(conf, cache);
+
+    // sample only the even lattice indices along dim, the others are
+    // their negatives
+    ArrayFi shift;
+    conf.conjugateShift(m_nodes.back().properties.outputGrid(), shift);
+    ArrayFi resolution = conf.finest_resolution();
+    resolution[dim] /= 2;
+    SamplingProperties half(resolution, conf.base_frequency());
+
+    return conjugate_complete(evaluateAll(half, cache), dim, shift);
+  }
+
+  int DagEvaluator::conjugateDimension(const SamplingProperties& conf) const
+  {
+    const Node& root = m_nodes.back();
+    ArrayFi shift;
+    if (!conf.conjugateShift(root.properties.outputGrid(), shift))
+      return -1;
+
+    // The even lattice indices along a dimension are the negatives of the
+    // odd ones, if the shift is odd. They are sampled by the half
+    // resolution, which every builder has to support.
+    ArrayFi resolution = conf.finest_resolution();
+    int dim = -1;
+    for (int j = 0; j < resolution.rows() && dim < 0; ++j) {
+      if (mod(shift[j], 2) != 1 || resolution[j] % 2 != 0)
+        continue;
+
+      ArrayFi half = resolution;
+      half[j] /= 2;
+      bool supported = true;
+      for (size_t i = 0; i < m_nodes.size() && supported; ++i) {
+        const FoProperties& props = m_nodes[i].properties;
+        supported = samples(props.output(), half)
+          && samples(props.input(), half);
+      }
+      if (supported)
+        dim = j;
+    }
+
+    if (dim >= 0 && !has_real_coefficients(*root.builder, conf))
+      return -1;
+
+    return dim;
+  }
+
+  Symbol DagEvaluator::evaluateAll(const SamplingProperties& conf,
+                                   SymbolCache* cache) const
+  {
+    int n = m_nodes.size();
+    vector<Symbol> symbols(n);
+    vector<bool> wanted(n, false);
+    wanted[n-1] = true;
+
+    compute(conf, expansionFactors(conf), ParameterValues(), cache,
+            vector<bool>(n, true), vector<bool>(n, false), vector<Symbol>(),
+            wanted, symbols);
+
+    return std::move(symbols[n-1]);
+  }
+
+  vector<Symbol>
+  DagEvaluator::sweep(const SamplingProperties& conf,
+                      const vector<ParameterValues>& points,
+                      SymbolCache* cache) const
+  {
+    int n = m_nodes.size();
+    vector<Symbol> constant = evaluateConstant(conf, cache);
+
+    vector<Symbol> result;
+    result.reserve(points.size());
+    if (!variableNodes()[n-1]) {
+      result.assign(points.size(), constant[n-1]);
+      return result;
+    }
+
+    for (size_t i = 0; i < points.size(); ++i) {
+      result.push_back(evaluate(conf, points[i], constant));
+    }
+
+    return result;
+  }
+
+  vector<Symbol>
+  DagEvaluator::evaluateConstant(const SamplingProperties& conf,
+                                 SymbolCache* cache) const
+  {
+    int n = m_nodes.size();
+    vector<bool> variable = variableNodes();
+    vector<bool> cacheable(n);
+    for (int i = 0; i < n; ++i) {
+      cacheable[i] = !variable[i];
+    }
+
+    vector<Symbol> symbols(n);
+    compute(conf, expansionFactors(conf), ParameterValues(), cache,
+            cacheable, vector<bool>(n, false), vector<Symbol>(),
+            constantNodes(), symbols);
+
+    return symbols;
+  }
+
+  Symbol DagEvaluator::evaluate(const SamplingProperties& conf,
+                                const ParameterValues& values,
+                                const vector<Symbol>& constant) const
+  {
+    int n = m_nodes.size();
+    if (int(constant.size()) != n)
+      throw logic_error("The constant symbols do not match the graph.");
+
+    // check the names, such that misspelled parameters are noticed
+    vector<string> names = parameters();
+    for (ParameterValues::const_iterator it = values.begin();
+         it != values.end(); ++it)
+    {
+      if (std::find(names.begin(), names.end(), it->first) == names.end())
+        throw logic_error("Unknown parameter: " + it->first);
+    }
+
+    vector<bool> known = constantNodes();
+    if (known[n-1])
+      return constant[n-1];
+
+    vector<Symbol> symbols(n);
+    vector<bool> wanted(n, false);
+    wanted[n-1] = true;
+
+    compute(conf, expansionFactors(conf), values, nullptr,
+            vector<bool>(n, false), known, constant, wanted, symbols);
+
+    return std::move(symbols[n-1]);
+  }
+
+  vector<string> DagEvaluator::parameters() const
+  {
+    vector<string> names;
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+      vector<string> p = m_nodes[i].builder->parameters();
+      for (size_t j = 0; j < p.size(); ++j) {
+        if (std::find(names.begin(), names.end(), p[j]) == names.end())
+          names.push_back(p[j]);
+      }
+    }
+    return names;
+  }
+
+  vector<bool> DagEvaluator::variableNodes() const
+  {
+    int n = m_nodes.size();
+    vector<bool> variable(n, false);
+    for (int i = 0; i < n; ++i) {
+      const Node& node = m_nodes[i];
+      variable[i] = !node.builder->parameters().empty();
+      for (size_t j = 0; j < node.dependencies.size(); ++j) {
+        variable[i] = variable[i] || variable[node.dependencies[j]];
+      }
+    }
+    return variable;
+  }
+
+  vector<bool> DagEvaluator::constantNodes() const
+  {
+    int n = m_nodes.size();
+    vector<bool> variable = variableNodes();
+
+    vector<bool> constant(n, false);
+    constant[n-1] = !variable[n-1];
+    for (int i = 0; i < n; ++i) {
+      if (!variable[i])
+        continue;
+
+      const Node& node = m_nodes[i];
+      for (size_t j = 0; j < node.dependencies.size(); ++j) {
+        int d = node.dependencies[j];
+        if (!variable[d])
+          constant[d] = true;
+      }
+    }
+    return constant;
+  }
+
+  void DagEvaluator::compute(const SamplingProperties& conf,
+                             const vector<ArrayFi>& factors,
+                             const ParameterValues& values,
+                             SymbolCache* cache,
+                             const vector<bool>& cacheable,
+                             const vector<bool>& known,
+                             const vector<Symbol>& known_symbols,
+                             const vector<bool>& wanted,
+                             vector<Symbol>& symbols) const
+  {
+    int n = m_nodes.size();
+
+    // Determine the nodes that have to be computed. The dependencies of a
+    // node that is known or found in the cache are not needed.
+    vector<bool> needed = wanted;
+    vector<bool> computed(n, false);
+    for (int i = n-1; i >= 0; --i) {
+      if (!needed[i] || known[i])
+        continue;
+
+      const Node& node = m_nodes[i];
+      if (cache && cacheable[i]
+          && cache->lookup(node.hash, *node.builder, conf, factors[i],
+                           symbols[i]))
+      {
+        continue;
+      }
+
+      computed[i] = true;
+      for (size_t j = 0; j < node.dependencies.size(); ++j) {
+        needed[node.dependencies[j]] = true;
+      }
+    }
+
+    // count the remaining uses of every symbol; the wanted symbols are
+    // kept
+    vector<int> references(n, 0);
+    for (int i = 0; i < n; ++i) {
+      if (wanted[i])
+        references[i] += 1;
+
+      if (!computed[i])
+        continue;
+
+      for (size_t j = 0; j < m_nodes[i].dependencies.size(); ++j) {
+        references[m_nodes[i].dependencies[j]] += 1;
+      }
+    }
+
+    for (int i = 0; i < n; ++i) {
+      if (!computed[i])
+        continue;
+
+      const Node& node = m_nodes[i];
+
+      // The symbol of a dependency is moved into the argument list when
+      // this is its last use, hence, it is released after the
+      // computation.
+      vector<Symbol> deps;
+      deps.reserve(node.dependencies.size());
+      for (size_t j = 0; j < node.dependencies.size(); ++j) {
+        int d = node.dependencies[j];
+        if (known[d]) {
+          deps.push_back(known_symbols[d]);
+          continue;
+        }
+
+        references[d] -= 1;
+        if (references[d] == 0) {
+          deps.push_back(std::move(symbols[d]));
+        } else {
+          deps.push_back(symbols[d]);
+        }
+      }
+
+      if (deps.empty()) {
+        symbols[i] = node.builder->generateExpanded(conf, factors[i]);
+      } else {
+        symbols[i] = node.builder->combineWith(conf, deps, values);
+
+        // merge the clusters further, if the dependencies did not
+        ArrayFi base = symbols[i].baseIndices().shape();
+        ArrayFi target = natural_base(node.properties, conf) / factors[i];
+        if ((base != target).any())
+          symbols[i] = symbols[i].expand(base / target);
+      }
+
+      if (cache && cacheable[i])
+        cache->insert(node.hash, node.builder, conf, factors[i], symbols[i]);
+    }
+  }
+
+}
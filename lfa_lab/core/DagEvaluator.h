@@ -0,0 +1,150 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_DAG_EVALUATOR_H
+#define LFA_DAG_EVALUATOR_H
+
+#include "Common.h"
+#include "SymbolBuilder.h"
+#include "SymbolCache.h"
+
+#include <map>
+
+namespace lfa {
+
+  /** Computes the symbol of a directed acyclic graph of symbol builders.
+   *
+   * The graph is sorted once, such that every builder comes after its
+   * dependencies. Builders that are structurally equal (see
+   * structurally_equal) are merged. Every builder is evaluated once per
+   * sampling, even if several builders depend on it, and its symbol is
+   * released as soon as the last builder that depends on it has been
+   * evaluated. If all builders that use a symbol need its clusters merged,
+   * the symbol is generated with merged clusters right away (see
+   * SymbolBuilder::generateExpanded).
+   *
+   * If the graph has real coefficients (see has_real_coefficients) and
+   * the sampling contains the negative of every frequency, the clusters
+   * come in complex conjugate pairs. Then, evaluate samples only every
+   * second frequency along one dimension (see conjugateDimension) and
+   * fills in the remaining clusters by conjugation.
+   */
+  class DagEvaluator {
+    public:
+      explicit DagEvaluator(SymbolBuilderPtr root);
+
+      /** Compute the symbol of the root. This method may be called
+       * concurrently.
+       * @param cache If given, symbols found in the cache are not
+       *   recomputed, and all computed symbols are stored in the cache.
+       */
+      Symbol evaluate(const SamplingProperties& conf,
+                      SymbolCache* cache = nullptr) const;
+
+      /** The dimension along which evaluate samples only the even lattice
+       * indices, because the clusters of the odd ones are the conjugates
+       * of theirs, or -1, if the whole sampling is evaluated. */
+      int conjugateDimension(const SamplingProperties& conf) const;
+
+      /** Compute the symbol of the root for every point of a parameter
+       * sweep. The symbols that do not depend on any parameter are
+       * computed only once (see evaluateConstant), only the builders that
+       * depend on a parameter are evaluated for every point. Parameters
+       * that a point does not specify keep their default value (see
+       * ParameterSb).
+       * @param cache Used for the symbols that do not depend on a
+       *   parameter.
+       */
+      vector<Symbol> sweep(const SamplingProperties& conf,
+                           const vector<ParameterValues>& points,
+                           SymbolCache* cache = nullptr) const;
+
+      /** Compute the symbols that do not depend on any parameter, but are
+       * used by builders that do, or by nobody, if the root does not
+       * depend on a parameter. The result can be passed to evaluate to
+       * compute the symbol for different parameter values. */
+      vector<Symbol> evaluateConstant(const SamplingProperties& conf,
+                                      SymbolCache* cache = nullptr) const;
+
+      /** Compute the symbol of the root for the given parameter values.
+       * @param constant The result of evaluateConstant for the same
+       *   sampling.
+       */
+      Symbol evaluate(const SamplingProperties& conf,
+                      const ParameterValues& values,
+                      const vector<Symbol>& constant) const;
+
+      /** The names of all parameters in the graph. */
+      vector<string> parameters() const;
+
+      /** The number of distinct builders in the graph. */
+      int size() const { return m_nodes.size(); }
+    private:
+      struct Node {
+        SymbolBuilderPtr builder;
+        /** Position of the dependencies in m_nodes. */
+        vector<int> dependencies;
+        /** The structural hash of the builder. */
+        size_t hash;
+        FoProperties properties;
+      };
+
+      /** Compute the symbol of the root for every frequency of the
+       * sampling. */
+      Symbol evaluateAll(const SamplingProperties& conf,
+                         SymbolCache* cache) const;
+
+      /** The factor by which the clusters of every symbol are merged. */
+      vector<ArrayFi> expansionFactors(const SamplingProperties& conf) const;
+
+      /** Does the symbol of the node depend on a parameter? */
+      vector<bool> variableNodes() const;
+
+      /** The nodes that do not depend on a parameter, but whose symbols
+       * are used by nodes that do (or the root). */
+      vector<bool> constantNodes() const;
+
+      /** Compute the symbols of the wanted nodes.
+       * @param known The nodes whose symbols are given in known_symbols.
+       * @param cacheable The nodes whose symbols may be taken from and
+       *   stored in the cache.
+       */
+      void compute(const SamplingProperties& conf,
+                   const vector<ArrayFi>& factors,
+                   const ParameterValues& values,
+                   SymbolCache* cache,
+                   const vector<bool>& cacheable,
+                   const vector<bool>& known,
+                   const vector<Symbol>& known_symbols,
+                   const vector<bool>& wanted,
+                   vector<Symbol>& symbols) const;
+
+      /** Append the node and all its dependencies to m_nodes, if not
+       * already present. Returns the position of the node. */
+      int visit(SymbolBuilderPtr builder,
+                std::map<SymbolBuilder*, int>& visited);
+
+      vector<Node> m_nodes;
+      /** The positions of the nodes, indexed by their hash. */
+      std::multimap<size_t, int> m_index;
+  };
+
+}
+
+#endif
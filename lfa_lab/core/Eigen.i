@@ -134,6 +134,27 @@ T pythonToArray(PyObject* input)
     return result;
 }
 
+/** The data of a writeable, Fortran-contiguous NumPy array of doubles with
+ * the given number of elements. Returns nullptr for None. */
+double* numpyDoubleBuffer(PyObject* obj, int size)
+{
+    if (obj == Py_None)
+        return nullptr;
+
+    if (!PyArray_Check(obj))
+        throw std::runtime_error("Expected a NumPy array.");
+
+    PyArrayObject* arr = reinterpret_cast<PyArrayObject*>(obj);
+    if (PyArray_TYPE(arr) != NPY_DOUBLE || !PyArray_ISFARRAY(arr))
+        throw std::runtime_error(
+            "Expected a writeable Fortran-ordered array of doubles.");
+
+    if (PyArray_SIZE(arr) != size)
+        throw std::runtime_error("Array has the wrong size.");
+
+    return reinterpret_cast<double*>(PyArray_DATA(arr));
+}
+
 template <typename T>
 PyObject* arrayToPython(const T& vec)
 {
@@ -44,11 +44,27 @@ extern "C" void zgeev_ (
         const int* LWORK,
         double* RWORK,
         int* INFO);
+
+extern "C" void dgeev_ (
+        const char* JOBVL,
+        const char* JOBVR,
+        const int* N,
+        double* A,  // will be overwritten
+        const int* LDA,
+        double* WR,
+        double* WI,
+        double* VL,
+        const int* LDVL,
+        double* VR,
+        const int* LDVR,
+        double* WORK,
+        const int* LWORK,
+        int* INFO);
 #else
     #include <Eigen/Eigenvalues>
 #endif
 
-#if defined(WITH_LAPACK) && defined(WITH_OUTER_PARALLEL)
+#if defined(WITH_LAPACK) && defined(WITH_OPENMP) && !defined(LAPACK_REENTRANT)
 #warning LAPACK is not thread safe. It will be used in a serail fashion. \
     This may degenerate performance.
 #endif
@@ -59,62 +75,197 @@ extern "C" void zgeev_ (
 
 namespace lfa {
 
-Eigen::VectorXcd eigenvalues(const Eigen::MatrixXcd& A)
+EigenvalueSolver::EigenvalueSolver()
+    : m_size(-1),
+      m_real_size(-1)
+{ }
+
+void EigenvalueSolver::prepare(int n)
+{
+#ifdef WITH_LAPACK
+    if (n == m_size)
+        return;
+
+    m_size = -1;
+    m_A.resize(n, n);
+    m_rwork.resize(2*n);
+
+    int N = n;
+    int LDA = std::max(N, 1);
+    VectorXcd W(N);
+    std::complex<double>* const VL = nullptr;
+    int LDVL = 1;
+    std::complex<double>* const VR = nullptr;
+    int LDVR = 1;
+
+    std::complex<double> work_size;
+    int query = -1;
+    int INFO;
+
+    // Determine the size of the work array
+#ifndef LAPACK_REENTRANT
+    #pragma omp critical(lfa_lapack)
+#endif
+    zgeev_("N", "N",
+            &N, m_A.data(), &LDA, W.data(),
+            VL, &LDVL, VR, &LDVR,
+            &work_size, &query, m_rwork.data(), &INFO);
+
+    if (INFO != 0)
+        throw runtime_error("Eigenvalue computation failed.");
+
+    m_work.resize(std::max(int(real(work_size)), 1));
+    m_size = n;
+#else
+    m_size = n;
+#endif
+}
+
+void EigenvalueSolver::prepareReal(int n)
 {
-    using Eigen::MatrixXcd;
-    using Eigen::VectorXcd;
-    using Eigen::VectorXd;
+    if (n == m_real_size)
+        return;
+
+    m_real_size = -1;
+    m_real_A.resize(n, n);
+    m_wr.resize(n);
+    m_wi.resize(n);
 
+#ifdef WITH_LAPACK
+    int N = n;
+    int LDA = std::max(N, 1);
+    double* const VL = nullptr;
+    int LDVL = 1;
+    double* const VR = nullptr;
+    int LDVR = 1;
+
+    double work_size;
+    int query = -1;
+    int INFO;
+
+    // Determine the size of the work array
+#ifndef LAPACK_REENTRANT
+    #pragma omp critical(lfa_lapack)
+#endif
+    dgeev_("N", "N",
+            &N, m_real_A.data(), &LDA, m_wr.data(), m_wi.data(),
+            VL, &LDVL, VR, &LDVR,
+            &work_size, &query, &INFO);
+
+    if (INFO != 0)
+        throw runtime_error("Eigenvalue computation failed.");
+
+    m_real_work.resize(std::max(int(work_size), 1));
+#endif
+    m_real_size = n;
+}
+
+VectorXcd EigenvalueSolver::eigenvalues(
+        const Eigen::Ref<const MatrixXcd>& A)
+{
+    VectorXcd W(A.rows());
+    eigenvalues(A, W);
+    return W;
+}
+
+void EigenvalueSolver::eigenvalues(const Eigen::Ref<const MatrixXcd>& A,
+                                   Eigen::Ref<VectorXcd> W)
+{
     if (A.rows() != A.cols()) {
         throw logic_error("Expecting a square matrix.");
     }
+    if (W.size() != A.rows()) {
+        throw logic_error("Dimensions mismatch");
+    }
     assert("Matrix is valid" && is_valid(A));
 
+    prepare(A.rows());
+
 #ifdef WITH_LAPACK
+    m_A = A;
 
-    int N = A.rows();
-    MatrixXcd A_aux = A;
-    int LDA = N;
-    VectorXcd W(N);
+    int N = m_size;
+    int LDA = std::max(N, 1);
     std::complex<double>* const VL = nullptr;
     int LDVL = 1;
     std::complex<double>* const VR = nullptr;
     int LDVR = 1;
-
-    VectorXcd WORK(1);
-    int LWORK = -1;
-    VectorXd RWORK(2*N);
+    int LWORK = m_work.size();
     int INFO;
 
-    // gfortran + LAPACK not thread safe
-    #pragma omp critical
-    {
-        // Determine the size of the work array
-        zgeev_("N", "N",
-                &N, A_aux.data(), &LDA, W.data(),
-                VL, &LDVL, VR, &LDVR,
-                WORK.data(), &LWORK, RWORK.data(), &INFO);
-
-        LWORK = real(WORK(0));
-        WORK.resize(LWORK);
-
-        // do the eigenvalue computation
-        zgeev_("N", "N",
-                &N, A_aux.data(), &LDA, W.data(),
-                VL, &LDVL, VR, &LDVR,
-                WORK.data(), &LWORK, RWORK.data(), &INFO);
+    // A non-reentrant LAPACK (e.g., gfortran with static locals) has to be
+    // called serially.
+#ifndef LAPACK_REENTRANT
+    #pragma omp critical(lfa_lapack)
+#endif
+    zgeev_("N", "N",
+            &N, m_A.data(), &LDA, W.data(),
+            VL, &LDVL, VR, &LDVR,
+            m_work.data(), &LWORK, m_rwork.data(), &INFO);
+
+    if (INFO != 0)
+        throw runtime_error("Eigenvalue computation failed.");
+#else
+    Eigen::ComplexEigenSolver<MatrixXcd> eigs_comp(A, false);
+
+    W = eigs_comp.eigenvalues();
+#endif
+}
+
+void EigenvalueSolver::realEigenvalues(
+        const Eigen::Ref<const MatrixXd>& A,
+        Eigen::Ref<VectorXcd> W)
+{
+    if (A.rows() != A.cols()) {
+        throw logic_error("Expecting a square matrix.");
+    }
+    if (W.size() != A.rows()) {
+        throw logic_error("Dimensions mismatch");
     }
 
+    prepareReal(A.rows());
+
+#ifdef WITH_LAPACK
+    m_real_A = A;
+
+    int N = m_real_size;
+    int LDA = std::max(N, 1);
+    double* const VL = nullptr;
+    int LDVL = 1;
+    double* const VR = nullptr;
+    int LDVR = 1;
+    int LWORK = m_real_work.size();
+    int INFO;
+
+#ifndef LAPACK_REENTRANT
+    #pragma omp critical(lfa_lapack)
+#endif
+    dgeev_("N", "N",
+            &N, m_real_A.data(), &LDA, m_wr.data(), m_wi.data(),
+            VL, &LDVL, VR, &LDVR,
+            m_real_work.data(), &LWORK, &INFO);
+
     if (INFO != 0)
         throw runtime_error("Eigenvalue computation failed.");
 
-    return W;
+    for (int i = 0; i < N; ++i) {
+        W(i) = std::complex<double>(m_wr(i), m_wi(i));
+    }
 #else
-    Eigen::ComplexEigenSolver<Eigen::MatrixXcd> eigs_comp(A, false);
+    Eigen::EigenSolver<MatrixXd> eigs_real(A, false);
 
-    return eigs_comp.eigenvalues();
+    W = eigs_real.eigenvalues();
 #endif
 }
 
+VectorXcd eigenvalues(const MatrixXcd& A)
+{
+    // Every thread keeps its own solver, hence, the work arrays are reused
+    // by consecutive calls of the same size.
+    static thread_local EigenvalueSolver solver;
+
+    return solver.eigenvalues(A);
+}
+
 }
 
@@ -24,6 +24,50 @@
 
 namespace lfa {
 
+  /** Computes the eigenvalues of many matrices of the same size.
+   *
+   * The work arrays are allocated, and with LAPACK the size of the work
+   * array is queried, only when the size of the matrix changes. Hence,
+   * a single solver should be reused for all the blocks of a block
+   * diagonal matrix. A solver must not be shared between threads.
+   */
+  class EigenvalueSolver {
+    public:
+      EigenvalueSolver();
+
+      /** Computes the eigenvalues of the matrix A. */
+      Eigen::VectorXcd eigenvalues(
+          const Eigen::Ref<const Eigen::MatrixXcd>& A);
+
+      /** Computes the eigenvalues of the matrix A and stores them in W. */
+      void eigenvalues(const Eigen::Ref<const Eigen::MatrixXcd>& A,
+                       Eigen::Ref<Eigen::VectorXcd> W);
+
+      /** Computes the eigenvalues of the real matrix A and stores them in
+       * W. This uses real arithmetic, which is cheaper than computing the
+       * eigenvalues of A as a complex matrix. */
+      void realEigenvalues(const Eigen::Ref<const Eigen::MatrixXd>& A,
+                           Eigen::Ref<Eigen::VectorXcd> W);
+
+      /** The size of the matrices the work arrays are prepared for. */
+      int size() const { return m_size; }
+
+    private:
+      void prepare(int n);
+      void prepareReal(int n);
+
+      int m_size;
+      Eigen::MatrixXcd m_A;
+      Eigen::VectorXcd m_work;
+      Eigen::VectorXd m_rwork;
+
+      // the work arrays of the real eigenvalue problem
+      int m_real_size;
+      Eigen::MatrixXd m_real_A;
+      Eigen::VectorXd m_real_work;
+      Eigen::VectorXd m_wr, m_wi;
+  };
+
   /** Computes the eigenvalues of a matrix. */
   VectorXcd eigenvalues(const Eigen::MatrixXcd& A);
 
@@ -24,9 +24,13 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cmath>
 #include <stdexcept>
 #include "Common.h"
 
+#include <Eigen/SVD>
+#include <Eigen/Eigenvalues>
+
 using std::strcpy;
 using std::stringstream;
 using std::endl;
@@ -83,6 +87,14 @@ extern "C" void zneupd_(
 namespace lfa {
 
 std::complex<double> eigenvalue_max_magnitude(const MatrixXcd& M)
+{
+    static thread_local EigenvalueSolver solver;
+
+    return eigenvalue_max_magnitude(M, solver);
+}
+
+std::complex<double> eigenvalue_max_magnitude(const Ref<const MatrixXcd>& M,
+                                              EigenvalueSolver& solver)
 {
 #ifdef WITH_ARPACK
     if (M.rows() <= 32)
@@ -90,7 +102,7 @@ std::complex<double> eigenvalue_max_magnitude(const MatrixXcd& M)
 #endif
         // "directly" solve the eigenvalue problem, if ARPACK is not used or
         // the problem is small enough
-        VectorXcd eigs = eigenvalues(M);
+        VectorXcd eigs = solver.eigenvalues(M);
 
         double max_amp = abs(eigs(0));
         for (int i = 1; i < M.rows(); ++i)
@@ -306,5 +318,101 @@ std::complex<double> eigenvalue_max_magnitude(const MatrixXcd& M)
 
 }
 
+double singular_value_max(const Ref<const MatrixXcd>& M, int* steps)
+{
+    if (steps)
+        *steps = 0;
+
+    if (M.rows() == 0 || M.cols() == 0)
+        return 0;
+
+    if (M.rows() == 1 && M.cols() == 1)
+        return abs(M(0,0));
+
+    if (std::min(M.rows(), M.cols()) <= 32)
+    {
+        JacobiSVD<MatrixXcd> svd(M);
+        return svd.singularValues()(0);
+    }
+
+    // Golub-Kahan-Lanczos bidiagonalization M V = U B with full
+    // reorthogonalization. The largest singular value of the upper
+    // bidiagonal B (with the diagonal alpha and the superdiagonal beta) is
+    // the largest Ritz value and converges to the largest singular value of
+    // M. A cluster of nearly equal largest singular values is resolved up
+    // to the width of the cluster within a few steps. After min(rows, cols)
+    // steps, the Ritz value is exact.
+    const double tol = 1e-13;
+
+    int m = M.rows();
+    int n = M.cols();
+    int max_steps = std::min(m, n);
+    double breakdown = NumTraits<double>::epsilon() * M.norm();
+
+    MatrixXcd U(m, max_steps);
+    MatrixXcd V(n, max_steps);
+    VectorXd alpha(max_steps);
+    VectorXd beta(max_steps);
+
+    // The starting vector must not be orthogonal to the dominant singular
+    // vector. Symbols are often symmetric, hence, a constant vector is
+    // avoided.
+    for (int i = 0; i < n; ++i) {
+        V(i, 0) = complex<double>(1.0 + 0.5 * std::sin(1.0 + i),
+                                  std::cos(2.0 * i));
+    }
+    V.col(0).normalize();
+
+    VectorXcd u(m);
+    VectorXcd v(n);
+    // the tridiagonal B^H B, whose largest eigenvalue is the squared Ritz
+    // value
+    VectorXd diag(max_steps);
+    VectorXd subdiag(max_steps);
+    SelfAdjointEigenSolver<MatrixXd> ritz;
+    double theta = 0;
+
+    int k = 0;
+    while (true)
+    {
+        // u_k = (M v_k - beta_{k-1} u_{k-1}) / alpha_k
+        u.noalias() = M * V.col(k);
+        for (int pass = 0; pass < 2; ++pass)
+            u.noalias() -= U.leftCols(k) * (U.leftCols(k).adjoint() * u);
+        alpha(k) = u.norm();
+
+        diag(k) = alpha(k) * alpha(k) + (k > 0 ? beta(k-1) * beta(k-1) : 0);
+        if (k > 0)
+            subdiag(k-1) = alpha(k-1) * beta(k-1);
+        ++k;
+
+        ritz.computeFromTridiagonal(diag.head(k), subdiag.head(k-1),
+                                    EigenvaluesOnly);
+        double previous = theta;
+        theta = ritz.eigenvalues()(k-1);
+
+        if (k == max_steps || alpha(k-1) <= breakdown
+            || theta - previous <= tol * theta)
+            break;
+
+        U.col(k-1) = u / alpha(k-1);
+
+        // v_{k+1} = (M^H u_k - alpha_k v_k) / beta_k
+        v.noalias() = M.adjoint() * U.col(k-1);
+        for (int pass = 0; pass < 2; ++pass)
+            v.noalias() -= V.leftCols(k) * (V.leftCols(k).adjoint() * v);
+        beta(k-1) = v.norm();
+
+        if (beta(k-1) <= breakdown)
+            break;
+
+        V.col(k) = v / beta(k-1);
+    }
+
+    if (steps)
+        *steps = k;
+
+    return sqrt(std::max(theta, 0.0));
 }
 
+}
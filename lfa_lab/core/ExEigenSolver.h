@@ -21,6 +21,7 @@
 #define LFA_EX_EIGEN_SOLVER_H
 
 #include "Common.h"
+#include "EigenSolver.h"
 #include <complex>
 
 namespace lfa {
@@ -33,6 +34,20 @@ namespace lfa {
    * An Arnoldi method is used if ARPACK support is enabled.
    */
   complex<double> eigenvalue_max_magnitude(const MatrixXcd& M);
+
+  /** Compute the eigenvalue with largest magnitude, reusing the work
+   * arrays of the given solver for small matrices. */
+  complex<double> eigenvalue_max_magnitude(const Ref<const MatrixXcd>& M,
+                                           EigenvalueSolver& solver);
+
+  /** Compute the largest singular value, i.e., the spectral norm.
+   *
+   * The product M^H M is never formed. Small matrices use a Jacobi SVD,
+   * larger ones a Lanczos bidiagonalization, which stops once the largest
+   * Ritz value stagnates, at the latest after min(rows, cols) steps. If
+   * steps is given, it receives the number of Lanczos steps taken.
+   */
+  double singular_value_max(const Ref<const MatrixXcd>& M, int* steps = 0);
 }
 
 
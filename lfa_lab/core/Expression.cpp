@@ -0,0 +1,187 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "Expression.h"
+#include "ExpressionSb.h"
+#include "DagEvaluator.h"
+#include "Simplifier.h"
+#include "BlockSb.h"
+
+#include <algorithm>
+
+namespace lfa {
+
+  Expression::Expression(SymbolBuilderPtr builder)
+    : m_builder(builder)
+  {
+    if (!m_builder)
+      throw logic_error("An expression requires a symbol builder.");
+  }
+
+  Expression::Expression(const FoStencil& stencil)
+    : m_builder(new FoStencil(stencil))
+  { }
+
+  Expression::Expression(const ConstantSb& builder)
+    : m_builder(new ConstantSb(builder))
+  { }
+
+  Expression::Expression(const HpFilterSb& builder)
+    : m_builder(new HpFilterSb(builder))
+  { }
+
+  Expression Expression::Identity(Grid grid)
+  {
+    return Expression(SymbolBuilderPtr(new IdentitySb(grid)));
+  }
+
+  Expression Expression::Zero(Grid grid)
+  {
+    return Expression(SymbolBuilderPtr(new ZeroSb(grid)));
+  }
+
+  Expression Expression::Block(NdArray<Expression> scalars)
+  {
+    NdRange indices = scalars.indices();
+    if (indices.dimension() == 0 || indices.size() == 0)
+      throw logic_error("A block operator requires scalar operators.");
+
+    NdArray<SymbolBuilderPtr> builders(scalars.shape());
+    for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p) {
+      builders(*p) = scalars(*p).builder();
+      if (!builders(*p))
+        throw logic_error("A scalar operator is missing.");
+    }
+
+    Grid grid = builders(ArrayFi::Zero(indices.dimension()))
+                  ->properties().outputGrid();
+
+    return Expression(SymbolBuilderPtr(new BlockSb(grid, builders)));
+  }
+
+  Expression Expression::operator+ (const Expression& other) const
+  {
+    return Expression(SymbolBuilderPtr(
+          new SumSb(m_builder, other.m_builder)));
+  }
+
+  Expression Expression::operator- (const Expression& other) const
+  {
+    return (*this) + (-1.0 * other);
+  }
+
+  Expression Expression::operator* (const Expression& other) const
+  {
+    return Expression(SymbolBuilderPtr(
+          new ProductSb(m_builder, other.m_builder)));
+  }
+
+  Expression operator* (complex<double> scalar, const Expression& expr)
+  {
+    return Expression(SymbolBuilderPtr(
+          new ScaledSb(scalar, expr.m_builder)));
+  }
+
+  Expression Expression::inverse() const
+  {
+    return Expression(SymbolBuilderPtr(new InverseSb(m_builder)));
+  }
+
+  Expression Expression::adjoint() const
+  {
+    return Expression(SymbolBuilderPtr(new AdjointSb(m_builder)));
+  }
+
+  Expression Expression::power(int p) const
+  {
+    return Expression(SymbolBuilderPtr(new PowerSb(m_builder, p)));
+  }
+
+  Expression Expression::polynomial(
+      const vector<complex<double> >& coefficients) const
+  {
+    return Expression(SymbolBuilderPtr(
+          new PolynomialSb(coefficients, m_builder)));
+  }
+
+  Expression Expression::parameterized(const string& name,
+                                       complex<double> value) const
+  {
+    return Expression(SymbolBuilderPtr(
+          new ParameterSb(name, value, m_builder)));
+  }
+
+  FoProperties Expression::properties() const
+  {
+    if (!m_builder)
+      throw logic_error("The expression is empty.");
+
+    return m_builder->properties();
+  }
+
+  Expression Expression::simplified() const
+  {
+    if (!m_builder)
+      throw logic_error("The expression is empty.");
+
+    return Expression(simplify(m_builder));
+  }
+
+  Symbol Expression::symbol(const SamplingProperties& conf) const
+  {
+    return DagEvaluator(simplify(m_builder))
+      .evaluate(conf, &SymbolCache::global());
+  }
+
+  vector<Symbol> Expression::sweep(const SamplingProperties& conf,
+                                   const vector<ParameterValues>& points)
+    const
+  {
+    return DagEvaluator(simplify(m_builder))
+      .sweep(conf, points, &SymbolCache::global());
+  }
+
+  // ParameterSweep
+
+  ParameterSweep::ParameterSweep(const Expression& expr,
+                                 const SamplingProperties& conf)
+    : m_evaluator(expr.simplified().builder()),
+      m_conf(conf)
+  {
+    m_constant = m_evaluator.evaluateConstant(conf, &SymbolCache::global());
+    m_parameters = m_evaluator.parameters();
+  }
+
+  void ParameterSweep::set(const string& name, complex<double> value)
+  {
+    if (std::find(m_parameters.begin(), m_parameters.end(), name)
+        == m_parameters.end())
+    {
+      throw logic_error("Unknown parameter: " + name);
+    }
+
+    m_values[name] = value;
+  }
+
+  Symbol ParameterSweep::symbol() const
+  {
+    return m_evaluator.evaluate(m_conf, m_values, m_constant);
+  }
+
+}
@@ -0,0 +1,132 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_EXPRESSION_H
+#define LFA_EXPRESSION_H
+
+#include "Common.h"
+#include "SymbolBuilder.h"
+#include "FoStencil.h"
+#include "ConstantSb.h"
+#include "HpFilterSb.h"
+#include "NdArray.h"
+#include "DagEvaluator.h"
+
+namespace lfa {
+
+  /** An operator expression whose symbol can be computed.
+   *
+   * The expression only describes how the symbol is built from the symbols
+   * of its operands. Copies of an expression share the same builder, hence,
+   * an operand that is used several times is only stored once.
+   */
+  class Expression {
+    public:
+      /** An empty expression. It has to be assigned before it is used. */
+      Expression() { }
+      explicit Expression(SymbolBuilderPtr builder);
+      Expression(const FoStencil& stencil);
+      Expression(const ConstantSb& builder);
+      Expression(const HpFilterSb& builder);
+
+      static Expression Identity(Grid grid);
+      static Expression Zero(Grid grid);
+
+      /** An operator that applies different scalar operators depending on
+       * the grid point. The pattern of the scalar operators is repeated
+       * over the whole domain. See BlockSb. */
+      static Expression Block(NdArray<Expression> scalars);
+
+      Expression operator+ (const Expression& other) const;
+      Expression operator- (const Expression& other) const;
+      Expression operator* (const Expression& other) const;
+
+      friend Expression operator* (complex<double> scalar,
+                                   const Expression& expr);
+
+      Expression inverse() const;
+      Expression adjoint() const;
+
+      /** The p-th power of the operator. See PowerSb. */
+      Expression power(int p) const;
+      /** The polynomial sum_k coefficients[k] * A^k of the operator A.
+       * See PolynomialSb. */
+      Expression polynomial(const vector<complex<double> >& coefficients)
+        const;
+
+      /** The expression multiplied by a named parameter. The value of the
+       * parameter can be varied without rebuilding the expression, see
+       * sweep and ParameterSweep. */
+      Expression parameterized(const string& name,
+                               complex<double> value) const;
+
+      FoProperties properties() const;
+
+      /** An equivalent expression that is cheaper to evaluate. See
+       * Simplifier. */
+      Expression simplified() const;
+
+      /** Compute the symbol of the whole expression. The expression is
+       * simplified first, and every subexpression is evaluated only once.
+       * Symbols that have been computed before are taken from the global
+       * SymbolCache. */
+      Symbol symbol(const SamplingProperties& conf) const;
+
+      /** Compute the symbol for every point of a parameter sweep. The parts
+       * of the expression that do not depend on a parameter are evaluated
+       * only once. See DagEvaluator::sweep. */
+      vector<Symbol> sweep(const SamplingProperties& conf,
+                           const vector<ParameterValues>& points) const;
+
+      SymbolBuilderPtr builder() const { return m_builder; }
+    private:
+      SymbolBuilderPtr m_builder;
+  };
+
+  /** Computes the symbol of an expression for changing parameter values.
+   *
+   * The symbols of the parts of the expression that do not depend on a
+   * parameter are computed once, when the sweep is created. Afterwards,
+   * only the builders that depend on a parameter are evaluated. This is
+   * the stateful counterpart of Expression::sweep.
+   */
+  class ParameterSweep {
+    public:
+      ParameterSweep(const Expression& expr, const SamplingProperties& conf);
+
+      /** Set the value of a parameter. Parameters that have not been set
+       * keep their default value. */
+      void set(const string& name, complex<double> value);
+
+      /** The symbol for the current parameter values. */
+      Symbol symbol() const;
+
+      /** The names of the parameters of the expression. */
+      const vector<string>& parameters() const { return m_parameters; }
+    private:
+      DagEvaluator m_evaluator;
+      SamplingProperties m_conf;
+      vector<Symbol> m_constant;
+      vector<string> m_parameters;
+      ParameterValues m_values;
+  };
+
+}
+
+#endif
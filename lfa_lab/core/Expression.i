@@ -0,0 +1,127 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+  vim: set filetype=cpp:
+*/
+
+%include "SymbolBuilder.i"
+%include "NdArray.i"
+
+%feature("autodoc", "An operator expression whose symbol can be computed
+by the core.") Expression;
+%feature("autodoc", "Compute the symbol of the whole expression.")
+Expression::symbol;
+%feature("autodoc", "An equivalent expression that is cheaper to
+evaluate.") Expression::simplified;
+%feature("autodoc", "The p-th power of the operator, computed by repeated
+squaring.") Expression::power;
+%feature("autodoc", "The polynomial sum_k c[k] A^k of the operator A,
+evaluated by the Horner scheme.") Expression::polynomial;
+%feature("autodoc", "The expression multiplied by a named parameter, whose
+value can be varied without rebuilding the expression.")
+Expression::parameterized;
+class Expression {
+  public:
+    Expression();
+    Expression(const FoStencil& stencil);
+    Expression(const ConstantSb& builder);
+    Expression(const HpFilterSb& builder);
+
+    static Expression Identity(Grid grid);
+    static Expression Zero(Grid grid);
+    static Expression Block(NdArray<Expression> scalars);
+
+    Expression inverse() const;
+    Expression adjoint() const;
+    Expression power(int p) const;
+    Expression parameterized(const std::string& name,
+                             std::complex<double> value) const;
+
+    FoProperties properties() const;
+    Expression simplified() const;
+    Symbol symbol(const SamplingProperties& conf) const;
+};
+
+%extend Expression {
+    Expression __add__(const Expression& other) {
+        return *$self + other;
+    }
+
+    Expression __sub__(const Expression& other) {
+        return *$self - other;
+    }
+
+    Expression __mul__(const Expression& other) {
+        return (*$self) * other;
+    }
+
+    Expression __rmul__(std::complex<double> scalar) {
+        return scalar * (*$self);
+    }
+
+    Expression polynomial(PyObject* coefficients) {
+        PyObject* seq = PySequence_Fast(coefficients,
+                                        "The coefficients must be a sequence.");
+        if (!seq)
+            throw std::logic_error("The coefficients must be a sequence.");
+
+        std::vector<std::complex<double> > c(PySequence_Fast_GET_SIZE(seq));
+        for (size_t k = 0; k < c.size(); ++k) {
+            Py_complex z =
+                PyComplex_AsCComplex(PySequence_Fast_GET_ITEM(seq, k));
+            if (z.real == -1.0 && PyErr_Occurred()) {
+                Py_DECREF(seq);
+                throw std::logic_error("The coefficients must be numbers.");
+            }
+            c[k] = std::complex<double>(z.real, z.imag);
+        }
+        Py_DECREF(seq);
+
+        return $self->polynomial(c);
+    }
+}
+
+%template(ExpressionNdArray) NdArray<Expression>;
+
+%feature("autodoc", "Computes the symbol of an expression for changing
+parameter values. The parts that do not depend on a parameter are only
+computed once.") ParameterSweep;
+%feature("autodoc", "Set the value of a parameter.") ParameterSweep::set;
+%feature("autodoc", "The symbol for the current parameter values.")
+ParameterSweep::symbol;
+%feature("autodoc", "The names of the parameters of the expression.")
+ParameterSweep::parameter_names;
+class ParameterSweep {
+  public:
+    ParameterSweep(const Expression& expr, const SamplingProperties& conf);
+
+    void set(const std::string& name, std::complex<double> value);
+    Symbol symbol() const;
+};
+
+%extend ParameterSweep {
+    PyObject* parameter_names() {
+        const std::vector<std::string>& names = $self->parameters();
+        PyObject* result = PyList_New(names.size());
+        for (size_t i = 0; i < names.size(); ++i) {
+            PyList_SET_ITEM(result, i,
+                            PyUnicode_FromString(names[i].c_str()));
+        }
+        return result;
+    }
+}
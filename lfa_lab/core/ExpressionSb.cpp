@@ -0,0 +1,502 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "ExpressionSb.h"
+#include "Hash.h"
+#include "DiscreteDomain.h"
+
+#include <functional>
+#include <typeinfo>
+
+namespace lfa {
+
+  // IdentitySb
+
+  IdentitySb::IdentitySb(Grid grid)
+    : m_grid(grid)
+  { }
+
+  FoProperties IdentitySb::properties()
+  {
+    SplitFrequencyDomain domain(m_grid);
+    return FoProperties(domain, domain);
+  }
+
+  Symbol IdentitySb::generate(const SamplingProperties& conf)
+  {
+    return Symbol::Identity(m_grid, conf);
+  }
+
+  Symbol IdentitySb::generateExpanded(const SamplingProperties& conf,
+                                      ArrayFi factor)
+  {
+    HarmonicClusters clusters =
+      DiscreteDomain(SplitFrequencyDomain(m_grid, factor), conf).harmonics();
+    return Symbol::Identity(clusters, clusters);
+  }
+
+  size_t IdentitySb::hash()
+  {
+    size_t seed = typeid(IdentitySb).hash_code();
+    hash_combine(seed, hash_value(m_grid));
+    return seed;
+  }
+
+  bool IdentitySb::equals(SymbolBuilder& other)
+  {
+    IdentitySb* o = dynamic_cast<IdentitySb*>(&other);
+    return o && identical(m_grid, o->m_grid);
+  }
+
+  // ZeroSb
+
+  ZeroSb::ZeroSb(Grid grid)
+    : m_grid(grid)
+  { }
+
+  FoProperties ZeroSb::properties()
+  {
+    SplitFrequencyDomain domain(m_grid);
+    return FoProperties(domain, domain);
+  }
+
+  Symbol ZeroSb::generate(const SamplingProperties& conf)
+  {
+    return Symbol::Zero(m_grid, conf);
+  }
+
+  Symbol ZeroSb::generateExpanded(const SamplingProperties& conf,
+                                  ArrayFi factor)
+  {
+    HarmonicClusters clusters =
+      DiscreteDomain(SplitFrequencyDomain(m_grid, factor), conf).harmonics();
+    return Symbol::Zero(clusters, clusters);
+  }
+
+  size_t ZeroSb::hash()
+  {
+    size_t seed = typeid(ZeroSb).hash_code();
+    hash_combine(seed, hash_value(m_grid));
+    return seed;
+  }
+
+  bool ZeroSb::equals(SymbolBuilder& other)
+  {
+    ZeroSb* o = dynamic_cast<ZeroSb*>(&other);
+    return o && identical(m_grid, o->m_grid);
+  }
+
+  // SumSb
+
+  SumSb::SumSb(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs)
+    : m_lhs(lhs), m_rhs(rhs)
+  { }
+
+  FoProperties SumSb::properties()
+  {
+    return m_lhs->properties() + m_rhs->properties();
+  }
+
+  Symbol SumSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> SumSb::dependencies()
+  {
+    vector<SymbolBuilderPtr> deps;
+    deps.push_back(m_lhs);
+    deps.push_back(m_rhs);
+    return deps;
+  }
+
+  Symbol SumSb::combine(const SamplingProperties& conf,
+                        const vector<Symbol>& symbols)
+  {
+    return symbols.at(0) + symbols.at(1);
+  }
+
+  size_t SumSb::hash()
+  {
+    return typeid(SumSb).hash_code();
+  }
+
+  bool SumSb::equals(SymbolBuilder& other)
+  {
+    return dynamic_cast<SumSb*>(&other) != nullptr;
+  }
+
+  // ProductSb
+
+  ProductSb::ProductSb(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs)
+    : m_lhs(lhs), m_rhs(rhs)
+  { }
+
+  FoProperties ProductSb::properties()
+  {
+    return m_lhs->properties() * m_rhs->properties();
+  }
+
+  Symbol ProductSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> ProductSb::dependencies()
+  {
+    vector<SymbolBuilderPtr> deps;
+    deps.push_back(m_lhs);
+    deps.push_back(m_rhs);
+    return deps;
+  }
+
+  Symbol ProductSb::combine(const SamplingProperties& conf,
+                            const vector<Symbol>& symbols)
+  {
+    return symbols.at(0) * symbols.at(1);
+  }
+
+  size_t ProductSb::hash()
+  {
+    return typeid(ProductSb).hash_code();
+  }
+
+  bool ProductSb::equals(SymbolBuilder& other)
+  {
+    return dynamic_cast<ProductSb*>(&other) != nullptr;
+  }
+
+  // ScaledSb
+
+  ScaledSb::ScaledSb(complex<double> scalar, SymbolBuilderPtr op)
+    : m_scalar(scalar), m_op(op)
+  { }
+
+  FoProperties ScaledSb::properties()
+  {
+    return m_scalar * m_op->properties();
+  }
+
+  Symbol ScaledSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> ScaledSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol ScaledSb::combine(const SamplingProperties& conf,
+                           const vector<Symbol>& symbols)
+  {
+    return m_scalar * symbols.at(0);
+  }
+
+  size_t ScaledSb::hash()
+  {
+    size_t seed = typeid(ScaledSb).hash_code();
+    hash_combine(seed, hash_value(m_scalar));
+    return seed;
+  }
+
+  bool ScaledSb::equals(SymbolBuilder& other)
+  {
+    ScaledSb* o = dynamic_cast<ScaledSb*>(&other);
+    return o && m_scalar == o->m_scalar;
+  }
+
+  // ParameterSb
+
+  ParameterSb::ParameterSb(const string& name,
+                           complex<double> value,
+                           SymbolBuilderPtr op)
+    : m_name(name), m_value(value), m_op(op)
+  { }
+
+  FoProperties ParameterSb::properties()
+  {
+    return m_op->properties();
+  }
+
+  Symbol ParameterSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> ParameterSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol ParameterSb::combine(const SamplingProperties& conf,
+                              const vector<Symbol>& symbols)
+  {
+    return m_value * symbols.at(0);
+  }
+
+  vector<string> ParameterSb::parameters()
+  {
+    return vector<string>(1, m_name);
+  }
+
+  Symbol ParameterSb::combineWith(const SamplingProperties& conf,
+                                  const vector<Symbol>& symbols,
+                                  const ParameterValues& values)
+  {
+    ParameterValues::const_iterator it = values.find(m_name);
+    complex<double> value = (it != values.end()) ? it->second : m_value;
+    return value * symbols.at(0);
+  }
+
+  size_t ParameterSb::hash()
+  {
+    size_t seed = typeid(ParameterSb).hash_code();
+    hash_combine(seed, std::hash<string>()(m_name));
+    hash_combine(seed, hash_value(m_value));
+    return seed;
+  }
+
+  bool ParameterSb::equals(SymbolBuilder& other)
+  {
+    ParameterSb* o = dynamic_cast<ParameterSb*>(&other);
+    return o && m_name == o->m_name && m_value == o->m_value;
+  }
+
+  // PowerSb
+
+  PowerSb::PowerSb(SymbolBuilderPtr op, int exponent)
+    : m_op(op), m_exponent(exponent)
+  {
+    if (exponent < 0)
+      throw logic_error("The exponent must not be negative.");
+  }
+
+  FoProperties PowerSb::properties()
+  {
+    FoProperties op = m_op->properties();
+    FoProperties result = op;
+    for (int k = 1; k < m_exponent; ++k) {
+      result = result * op;
+    }
+    return result;
+  }
+
+  Symbol PowerSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> PowerSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol PowerSb::combine(const SamplingProperties& conf,
+                          const vector<Symbol>& symbols)
+  {
+    return symbols.at(0).power(m_exponent);
+  }
+
+  size_t PowerSb::hash()
+  {
+    size_t seed = typeid(PowerSb).hash_code();
+    hash_combine(seed, m_exponent);
+    return seed;
+  }
+
+  bool PowerSb::equals(SymbolBuilder& other)
+  {
+    PowerSb* o = dynamic_cast<PowerSb*>(&other);
+    return o && m_exponent == o->m_exponent;
+  }
+
+  // PolynomialSb
+
+  PolynomialSb::PolynomialSb(const vector<complex<double> >& coefficients,
+                             SymbolBuilderPtr op)
+    : m_coefficients(coefficients), m_op(op)
+  { }
+
+  FoProperties PolynomialSb::properties()
+  {
+    // the sum of the powers has the properties of the highest power
+    FoProperties op = m_op->properties();
+    FoProperties result = op;
+    for (size_t k = 2; k < m_coefficients.size(); ++k) {
+      result = result * op;
+    }
+    return result;
+  }
+
+  Symbol PolynomialSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> PolynomialSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol PolynomialSb::combine(const SamplingProperties& conf,
+                               const vector<Symbol>& symbols)
+  {
+    return symbols.at(0).polynomial(m_coefficients);
+  }
+
+  size_t PolynomialSb::hash()
+  {
+    size_t seed = typeid(PolynomialSb).hash_code();
+    for (size_t k = 0; k < m_coefficients.size(); ++k) {
+      hash_combine(seed, hash_value(m_coefficients[k]));
+    }
+    return seed;
+  }
+
+  bool PolynomialSb::realCoefficients(const SamplingProperties& conf)
+  {
+    for (size_t k = 0; k < m_coefficients.size(); ++k) {
+      if (imag(m_coefficients[k]) != 0.0)
+        return false;
+    }
+    return true;
+  }
+
+  bool PolynomialSb::equals(SymbolBuilder& other)
+  {
+    PolynomialSb* o = dynamic_cast<PolynomialSb*>(&other);
+    return o && m_coefficients == o->m_coefficients;
+  }
+
+  // InverseSb
+
+  InverseSb::InverseSb(SymbolBuilderPtr op)
+    : m_op(op)
+  { }
+
+  FoProperties InverseSb::properties()
+  {
+    return m_op->properties().inverse();
+  }
+
+  Symbol InverseSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> InverseSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol InverseSb::combine(const SamplingProperties& conf,
+                            const vector<Symbol>& symbols)
+  {
+    return symbols.at(0).inverse();
+  }
+
+  size_t InverseSb::hash()
+  {
+    return typeid(InverseSb).hash_code();
+  }
+
+  bool InverseSb::equals(SymbolBuilder& other)
+  {
+    return dynamic_cast<InverseSb*>(&other) != nullptr;
+  }
+
+  // SolveSb
+
+  SolveSb::SolveSb(SymbolBuilderPtr op, SymbolBuilderPtr rhs)
+    : m_op(op), m_rhs(rhs)
+  { }
+
+  FoProperties SolveSb::properties()
+  {
+    return m_op->properties().inverse() * m_rhs->properties();
+  }
+
+  Symbol SolveSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> SolveSb::dependencies()
+  {
+    vector<SymbolBuilderPtr> deps;
+    deps.push_back(m_op);
+    deps.push_back(m_rhs);
+    return deps;
+  }
+
+  Symbol SolveSb::combine(const SamplingProperties& conf,
+                          const vector<Symbol>& symbols)
+  {
+    return symbols.at(0).solve(symbols.at(1));
+  }
+
+  size_t SolveSb::hash()
+  {
+    return typeid(SolveSb).hash_code();
+  }
+
+  bool SolveSb::equals(SymbolBuilder& other)
+  {
+    return dynamic_cast<SolveSb*>(&other) != nullptr;
+  }
+
+  // AdjointSb
+
+  AdjointSb::AdjointSb(SymbolBuilderPtr op)
+    : m_op(op)
+  { }
+
+  FoProperties AdjointSb::properties()
+  {
+    return m_op->properties().adjoint();
+  }
+
+  Symbol AdjointSb::generate(const SamplingProperties& conf)
+  {
+    return generateFromDependencies(conf);
+  }
+
+  vector<SymbolBuilderPtr> AdjointSb::dependencies()
+  {
+    return vector<SymbolBuilderPtr>(1, m_op);
+  }
+
+  Symbol AdjointSb::combine(const SamplingProperties& conf,
+                            const vector<Symbol>& symbols)
+  {
+    return symbols.at(0).adjoint();
+  }
+
+  size_t AdjointSb::hash()
+  {
+    return typeid(AdjointSb).hash_code();
+  }
+
+  bool AdjointSb::equals(SymbolBuilder& other)
+  {
+    return dynamic_cast<AdjointSb*>(&other) != nullptr;
+  }
+
+}
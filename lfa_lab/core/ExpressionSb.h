@@ -0,0 +1,323 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_EXPRESSION_SB_H
+#define LFA_EXPRESSION_SB_H
+
+#include "Common.h"
+#include "SymbolBuilder.h"
+#include "Grid.h"
+
+namespace lfa {
+
+  /** Builds the symbol of the identity on a grid. */
+  class IdentitySb : public SymbolBuilder {
+    public:
+      explicit IdentitySb(Grid grid);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+      Symbol generateExpanded(const SamplingProperties& conf,
+                              ArrayFi factor);
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      Grid grid() const { return m_grid; }
+    private:
+      Grid m_grid;
+  };
+
+  /** Builds the symbol of the zero operator on a grid. */
+  class ZeroSb : public SymbolBuilder {
+    public:
+      explicit ZeroSb(Grid grid);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+      Symbol generateExpanded(const SamplingProperties& conf,
+                              ArrayFi factor);
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      Grid grid() const { return m_grid; }
+    private:
+      Grid m_grid;
+  };
+
+  /** Builds the symbol of the sum of two operators. */
+  class SumSb : public SymbolBuilder {
+    public:
+      SumSb(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr lhs() const { return m_lhs; }
+      SymbolBuilderPtr rhs() const { return m_rhs; }
+    private:
+      SymbolBuilderPtr m_lhs;
+      SymbolBuilderPtr m_rhs;
+  };
+
+  /** Builds the symbol of the composition (product) of two operators. */
+  class ProductSb : public SymbolBuilder {
+    public:
+      ProductSb(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr lhs() const { return m_lhs; }
+      SymbolBuilderPtr rhs() const { return m_rhs; }
+    private:
+      SymbolBuilderPtr m_lhs;
+      SymbolBuilderPtr m_rhs;
+  };
+
+  /** Builds the symbol of an operator multiplied by a scalar. */
+  class ScaledSb : public SymbolBuilder {
+    public:
+      ScaledSb(complex<double> scalar, SymbolBuilderPtr op);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return imag(m_scalar) == 0.0;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      complex<double> scalar() const { return m_scalar; }
+      SymbolBuilderPtr op() const { return m_op; }
+    private:
+      complex<double> m_scalar;
+      SymbolBuilderPtr m_op;
+  };
+
+  /** Builds the symbol of an operator multiplied by a named parameter.
+   *
+   * The value of the parameter can be chosen each time the symbol is
+   * evaluated, see DagEvaluator::sweep. Otherwise, the default value is
+   * used. */
+  class ParameterSb : public SymbolBuilder {
+    public:
+      ParameterSb(const string& name,
+                  complex<double> value,
+                  SymbolBuilderPtr op);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+
+      vector<string> parameters();
+      Symbol combineWith(const SamplingProperties& conf,
+                         const vector<Symbol>& symbols,
+                         const ParameterValues& values);
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      const string& name() const { return m_name; }
+      /** The default value. */
+      complex<double> value() const { return m_value; }
+      SymbolBuilderPtr op() const { return m_op; }
+    private:
+      string m_name;
+      complex<double> m_value;
+      SymbolBuilderPtr m_op;
+  };
+
+  /** Builds the symbol of a power of an operator. The power is computed
+   * blockwise by repeated squaring, see Symbol::power. */
+  class PowerSb : public SymbolBuilder {
+    public:
+      PowerSb(SymbolBuilderPtr op, int exponent);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr op() const { return m_op; }
+      int exponent() const { return m_exponent; }
+    private:
+      SymbolBuilderPtr m_op;
+      int m_exponent;
+  };
+
+  /** Builds the symbol of a polynomial sum_k c_k A^k of an operator A.
+   * The polynomial is evaluated blockwise by the Horner scheme, see
+   * Symbol::polynomial. */
+  class PolynomialSb : public SymbolBuilder {
+    public:
+      /** @param coefficients The coefficients c_k, starting with the
+       *   constant term. */
+      PolynomialSb(const vector<complex<double> >& coefficients,
+                   SymbolBuilderPtr op);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf);
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      const vector<complex<double> >& coefficients() const {
+        return m_coefficients;
+      }
+      SymbolBuilderPtr op() const { return m_op; }
+    private:
+      vector<complex<double> > m_coefficients;
+      SymbolBuilderPtr m_op;
+  };
+
+  /** Builds the symbol of the inverse of an operator. */
+  class InverseSb : public SymbolBuilder {
+    public:
+      explicit InverseSb(SymbolBuilderPtr op);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr op() const { return m_op; }
+    private:
+      SymbolBuilderPtr m_op;
+  };
+
+  /** Builds the symbol of the product of the inverse of an operator with
+   * another operator. The symbol is computed by solving with the blocks of
+   * the inverted operator, see Symbol::solve. */
+  class SolveSb : public SymbolBuilder {
+    public:
+      /** The product op^{-1} * rhs. */
+      SolveSb(SymbolBuilderPtr op, SymbolBuilderPtr rhs);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr op() const { return m_op; }
+      SymbolBuilderPtr rhs() const { return m_rhs; }
+    private:
+      SymbolBuilderPtr m_op;
+      SymbolBuilderPtr m_rhs;
+  };
+
+  /** Builds the symbol of the adjoint of an operator. */
+  class AdjointSb : public SymbolBuilder {
+    public:
+      explicit AdjointSb(SymbolBuilderPtr op);
+
+      FoProperties properties();
+      Symbol generate(const SamplingProperties& conf);
+
+      vector<SymbolBuilderPtr> dependencies();
+      Symbol combine(const SamplingProperties& conf,
+                     const vector<Symbol>& symbols);
+      bool combinesExpanded() { return true; }
+      bool realCoefficients(const SamplingProperties& conf) {
+        return true;
+      }
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
+
+      SymbolBuilderPtr op() const { return m_op; }
+    private:
+      SymbolBuilderPtr m_op;
+  };
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "Fft.h"
+#include "MathUtil.h"
+
+namespace lfa {
+
+  namespace {
+
+    /** The smallest radix of the remaining length m, searching from the
+     * radix p on: the factors 4 first, then the primes. */
+    int next_radix(int m, int p)
+    {
+      while (m % p != 0) {
+        if (p == 4)
+          p = 2;
+        else if (p == 2)
+          p = 3;
+        else if (p * p > m)
+          p = m;
+        else
+          p += 2;
+      }
+      return p;
+    }
+
+  }
+
+  Fft::Fft(int n, int sign)
+    : m_n(n)
+  {
+    if (n < 1)
+      throw logic_error("The length of a Fourier transform must be "
+                        "positive.");
+
+    m_twiddles.resize(n);
+    for (int i = 0; i < n; ++i) {
+      m_twiddles[i] = exp(complex<double>(0, sign * 2.0 * pi * i / n));
+    }
+
+    int m = n;
+    int p = 4;
+    while (m > 1) {
+      p = next_radix(m, p);
+      m /= p;
+      m_factors.push_back(p);
+      m_factors.push_back(m);
+    }
+  }
+
+  void Fft::transform(const complex<double>* in,
+                      complex<double>* out) const
+  {
+    if (m_n == 1) {
+      out[0] = in[0];
+      return;
+    }
+
+    vector<complex<double> > scratch;
+    work(out, in, 1, 0, scratch);
+  }
+
+  void Fft::work(complex<double>* out,
+                 const complex<double>* in,
+                 int in_stride,
+                 int factor_index,
+                 vector<complex<double> >& scratch) const
+  {
+    int p = m_factors[factor_index];
+    int m = m_factors[factor_index + 1];
+
+    // the transforms of the p decimated sequences of length m
+    if (m == 1) {
+      for (int q = 0; q < p; ++q) {
+        out[q] = in[q * in_stride];
+      }
+    } else {
+      for (int q = 0; q < p; ++q) {
+        work(out + q * m, in + q * in_stride, in_stride * p,
+             factor_index + 2, scratch);
+      }
+    }
+
+    // butterflies of radix p; the twiddle factors of this stage are every
+    // in_stride-th twiddle of the full length
+    scratch.resize(p);
+    for (int u = 0; u < m; ++u) {
+      for (int q = 0; q < p; ++q) {
+        scratch[q] = out[u + q * m];
+      }
+
+      for (int q1 = 0; q1 < p; ++q1) {
+        int k = u + q1 * m;
+        int step = (in_stride * k) % m_n;
+        int tw = 0;
+
+        complex<double> sum = scratch[0];
+        for (int q = 1; q < p; ++q) {
+          tw += step;
+          if (tw >= m_n)
+            tw -= m_n;
+          sum += scratch[q] * m_twiddles[tw];
+        }
+        out[k] = sum;
+      }
+    }
+  }
+
+  FftNd::FftNd(ArrayFi shape, int sign)
+    : m_shape(shape)
+  {
+    for (int j = 0; j < shape.rows(); ++j) {
+      m_transforms.push_back(Fft(shape[j], sign));
+    }
+  }
+
+  void FftNd::transform(complex<double>* data) const
+  {
+    int size = m_shape.prod();
+    int stride = 1;
+
+    for (int j = 0; j < m_shape.rows(); ++j) {
+      int n = m_shape[j];
+      if (n > 1) {
+        vector<complex<double> > line(n), result(n);
+
+        // the lines along dimension j
+        int outer = size / (stride * n);
+        for (int o = 0; o < outer; ++o) {
+          for (int i = 0; i < stride; ++i) {
+            complex<double>* start = data + o * stride * n + i;
+            for (int k = 0; k < n; ++k) {
+              line[k] = start[k * stride];
+            }
+            m_transforms[j].transform(line.data(), result.data());
+            for (int k = 0; k < n; ++k) {
+              start[k * stride] = result[k];
+            }
+          }
+        }
+      }
+
+      stride *= n;
+    }
+  }
+
+  int fft_radix_sum(int n)
+  {
+    int sum = 0;
+    int m = n;
+    int p = 4;
+    while (m > 1) {
+      p = next_radix(m, p);
+      m /= p;
+      sum += p;
+    }
+    return sum;
+  }
+
+  void fft_nd(complex<double>* data, ArrayFi shape, int sign)
+  {
+    FftNd(shape, sign).transform(data);
+  }
+
+}
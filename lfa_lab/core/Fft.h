@@ -0,0 +1,83 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef LFA_FFT_H
+#define LFA_FFT_H
+
+#include "Common.h"
+
+namespace lfa {
+
+  /** A fast Fourier transform of a fixed length n. It computes
+   *
+   *   y_k = sum_j x_j exp(sign * 2 pi i j k / n)
+   *
+   * using a mixed-radix Cooley-Tukey algorithm. The cost is
+   * O(n (p_1 + ... + p_r)), where p_1 ... p_r are the prime factors of n.
+   * Hence, lengths with large prime factors are slow.
+   */
+  class Fft {
+    public:
+      /** @param sign The sign of the exponent, either -1 or +1. */
+      explicit Fft(int n, int sign = -1);
+
+      int size() const { return m_n; }
+
+      /** Transform in into out. The arrays must not overlap. This method
+       * may be called concurrently. */
+      void transform(const complex<double>* in, complex<double>* out) const;
+    private:
+      void work(complex<double>* out,
+                const complex<double>* in,
+                int in_stride,
+                int factor_index,
+                vector<complex<double> >& scratch) const;
+
+      int m_n;
+      /** Pairs of a radix p and the remaining length m. */
+      vector<int> m_factors;
+      vector<complex<double> > m_twiddles;
+  };
+
+  /** The Fourier transform of a multidimensional array along every
+   * dimension. The elements are ordered by their index, the first
+   * coordinate running fastest (see NdRange). */
+  class FftNd {
+    public:
+      explicit FftNd(ArrayFi shape, int sign = -1);
+
+      /** Transform the data in place. This method may be called
+       * concurrently with different data. */
+      void transform(complex<double>* data) const;
+    private:
+      ArrayFi m_shape;
+      vector<Fft> m_transforms;
+  };
+
+  /** Transform a multidimensional array along every dimension. See
+   * FftNd. */
+  void fft_nd(complex<double>* data, ArrayFi shape, int sign = -1);
+
+  /** The sum of the radices of the transform of length n, e.g., 4 + 4 + 2
+   * for n = 32. A transform costs about n times this sum complex
+   * multiply-adds, see Fft. */
+  int fft_radix_sum(int n);
+
+}
+
+#endif
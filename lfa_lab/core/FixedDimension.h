@@ -0,0 +1,94 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_FIXED_DIMENSION_H
+#define LFA_FIXED_DIMENSION_H
+
+#include "Common.h"
+
+namespace lfa {
+
+  /** Index type of the dimension D, which is either fixed or Dynamic. */
+  template <int D>
+  struct FixedIndex {
+    typedef Array<int, D, 1, ColMajor,
+                  (D == Dynamic ? MAX_DIMENSION : D), 1> type;
+  };
+
+  /** The dimension as a compile-time constant, if D is not Dynamic. */
+  template <int D>
+  inline int fixed_dimension(int d)
+  {
+    assert(D == Dynamic || D == d);
+    return (D == Dynamic) ? d : D;
+  }
+
+  /** Copy the index g of the dimension D into a dynamic index. The
+   * entries are copied one by one, with the compile-time trip count D,
+   * instead of a vectorized assignment, which would read past the end of
+   * a fixed-size index. */
+  template <int D>
+  inline ArrayFi dynamic_index(const typename FixedIndex<D>::type& g)
+  {
+    const int d = fixed_dimension<D>(g.size());
+    ArrayFi result(d);
+    for (int j = 0; j < d; ++j)
+      result[j] = g[j];
+    return result;
+  }
+
+  /** Advance the index g within shape, starting at the coordinate first.
+   * The coordinate first runs fastest. Returns false after the last
+   * index, where g is reset to the start. */
+  template <int D>
+  inline bool next_index(typename FixedIndex<D>::type& g,
+                         const typename FixedIndex<D>::type& shape,
+                         int first = 0)
+  {
+    const int d = fixed_dimension<D>(shape.size());
+    for (int j = first; j < d; ++j) {
+      if (++g[j] < shape[j])
+        return true;
+      g[j] = 0;
+    }
+    return false;
+  }
+
+  /** Call the kernel specialised for the dimension d.
+   *
+   * The kernel is a function object with a member template
+   *   template <int D> void run();
+   * which is instantiated for D = 1, 2, 3 and for D = Dynamic. In the
+   * specialisations, loops over the dimension have a constant trip count
+   * and are unrolled by the compiler.
+   */
+  template <typename Kernel>
+  void dispatch_dimension(int d, Kernel& kernel)
+  {
+    switch (d) {
+      case 1: kernel.template run<1>(); break;
+      case 2: kernel.template run<2>(); break;
+      case 3: kernel.template run<3>(); break;
+      default: kernel.template run<Dynamic>(); break;
+    }
+  }
+
+}
+
+#endif
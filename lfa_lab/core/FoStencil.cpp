@@ -21,12 +21,74 @@
 
 #include "SplitFrequencyDomain.h"
 #include "DiscreteDomain.h"
+#include "Hash.h"
+#include "MathUtil.h"
+#include "Fft.h"
+#include "FixedDimension.h"
+
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
 
 namespace lfa {
 
+  namespace {
+
+    /** Sums the stencil elements per offset in the first dimension, for
+     * every row of the lattice, see FoStencil::symbolOnLatticeSeparable. */
+    struct SeparableWeights {
+      SeparableWeights(const SparseStencil& stencil,
+                       const vector<MatrixXcd>& phases,
+                       const vector<vector<int> >& slot,
+                       const ArrayFi& resolution,
+                       MatrixXcd& weights)
+        : stencil(stencil), phases(phases), slot(slot),
+          resolution(resolution), weights(weights)
+      { }
+
+      template <int D>
+      void run()
+      {
+        typedef typename FixedIndex<D>::type Index;
+        const int d = fixed_dimension<D>(resolution.size());
+        const int nnz = stencil.nonZeros();
+
+        // column[j * nnz + k] is the phase column of element k in
+        // dimension j
+        vector<complex<double> > values(nnz);
+        vector<const complex<double>*> column(d * nnz);
+        for (int k = 0; k < nnz; ++k) {
+          values[k] = stencil[k].value;
+          for (int j = 1; j < d; ++j)
+            column[j * nnz + k] = phases[j].col(slot[j][k]).data();
+        }
+
+        Index shape = resolution;
+        Index g = Index::Zero(d);
+        for (int q = 0; q < weights.cols(); ++q) {
+          for (int k = 0; k < nnz; ++k) {
+            complex<double> w = values[k];
+            for (int j = 1; j < d; ++j)
+              w *= column[j * nnz + k][g[j]];
+            weights(slot[0][k], q) += w;
+          }
+          next_index<D>(g, shape, 1);
+        }
+      }
+
+      const SparseStencil& stencil;
+      const vector<MatrixXcd>& phases;
+      const vector<vector<int> >& slot;
+      ArrayFi resolution;
+      MatrixXcd& weights;
+    };
+
+  }
+
   FoStencil::FoStencil(const SparseStencil& stencil, Grid grid)
     : m_stencil(stencil),
-    m_grid(grid)
+    m_grid(grid),
+    m_real_symmetric(stencil.isRealSymmetric())
   {
 
   }
@@ -42,36 +104,240 @@ namespace lfa {
 
   Symbol FoStencil::generate(const SamplingProperties& conf)
   {
-    SplitFrequencyDomain cont_domain(
-        m_grid,
-        ArrayFi::Ones(m_grid.dimension()));
+    return generateExpanded(conf, ArrayFi::Ones(m_grid.dimension()));
+  }
+
+  Symbol FoStencil::generateExpanded(const SamplingProperties& conf,
+                                     ArrayFi factor)
+  {
+    // the symbol is diagonal, hence, merging the clusters only spreads the
+    // diagonal entries over larger clusters
+    SplitFrequencyDomain cont_domain(m_grid, factor);
 
     DiscreteDomain domain(cont_domain, conf);
+    VectorXcd values = symbolOnLattice(domain);
 
     HarmonicClusters clusters = domain.harmonics();
     Symbol sym(clusters, clusters);
 
-    NdRange bases = clusters.baseIndices();
-    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b)
-    {
-      SymbolClusterRef cluster(sym, *b);
-      fill(cluster, *b, domain);
+    // values is indexed by the linear global index
+    HarmonicIndexTable table = clusters.indexTable();
+    BdMatrix& matrix = sym.matrix();
+    for (int b = 0; b < table.baseSize(); ++b) {
+      for (int c = 0; c < table.clusterSize(); ++c) {
+        complex<double> v = values[table.global(b, c)];
+        // drop the rounding errors of a real symbol
+        matrix(b, c, c) = m_real_symmetric ? real(v) : v;
+      }
     }
+    matrix.setStructure(BdMatrix::Diagonal);
+    matrix.setReal(m_real_symmetric);
 
     return sym;
   }
 
+  VectorXcd FoStencil::symbolOnLattice(const DiscreteDomain& domain)
+  {
+    if (preferFft(domain.resolution()))
+      return symbolOnLatticeFft(domain);
+    else
+      return symbolOnLatticeSeparable(domain);
+  }
+
+  bool FoStencil::preferFft(ArrayFi resolution)
+  {
+    // Estimate the run time of both methods in nanoseconds. The constants
+    // have been measured for stencils of the width 3 to 63 in one to three
+    // dimensions, on resolutions with small and with large prime factors.
+    int d = dimension();
+    int nnz = m_stencil.nonZeros();
+    double size = resolution.prod();
+    double rows = size / resolution[0];
+
+    // the separable evaluation computes a complex exponential per distinct
+    // offset and lattice index of every dimension, sums the elements per
+    // row, and multiplies with the phase table of the first dimension
+    double exponentials = 0;
+    double first_offsets = 0;
+    for (int j = 0; j < d; ++j) {
+      vector<int> offsets;
+      for (int k = 0; k < nnz; ++k) {
+        int o = m_stencil[k].offset[j];
+        if (std::find(offsets.begin(), offsets.end(), o) == offsets.end())
+          offsets.push_back(o);
+      }
+      exponentials += double(resolution[j]) * offsets.size();
+      if (j == 0)
+        first_offsets = offsets.size();
+    }
+    double separable_cost = 25 * exponentials
+      + 3 * rows * nnz * (d - 1)
+      + 2 * size * first_offsets;
+
+    // the FFT is linear in the prime factors of the resolution (see Fft),
+    // and computes the twiddle factors of every dimension
+    double fft_cost = 0;
+    for (int j = 0; j < d; ++j) {
+      fft_cost += 5 * size * fft_radix_sum(resolution[j])
+                + 25 * resolution[j];
+    }
+
+    // the estimates are off by up to a factor of 1.25, the separable
+    // evaluation is the default
+    return 1.25 * fft_cost < separable_cost;
+  }
+
+  VectorXcd FoStencil::symbolOnLatticeFft(const DiscreteDomain& domain)
+  {
+    // With the frequencies f_j(g_j) = b_j + 2 pi g_j / (h_j R_j), the
+    // symbol is
+    //   sum_k v_k exp(i b.o_k h) exp(2 pi i sum_j g_j o_kj / R_j),
+    // i.e., the inverse DFT of the coefficients v_k exp(i b.o_k h) placed
+    // at the positions o_k mod R.
+    int d = dimension();
+    ArrayFi resolution = domain.resolution();
+    ArrayFd step_size = m_grid.step_size();
+    ArrayFd base_freq = domain.frequency(ArrayFi::Zero(d));
+
+    NdRange lattice(resolution);
+    VectorXcd values = VectorXcd::Zero(resolution.prod());
+    for (int k = 0; k < m_stencil.nonZeros(); ++k) {
+      const StencilElement& e = m_stencil[k];
+      ArrayFi pos = e.offset.binaryExpr(resolution, std::modulus<int>());
+      pos = (pos < 0).select(pos + resolution, pos);
+
+      double arg = (base_freq * e.offset.cast<double>() * step_size).sum();
+      values[lattice.indexOf(pos)] += e.value * exp(complex<double>(0, arg));
+    }
+
+    fft_nd(values.data(), resolution, 1);
+
+    return values;
+  }
+
+  VectorXcd FoStencil::symbolOnLatticeSeparable(const DiscreteDomain& domain)
+  {
+    // The symbol is a sum of products of one phase factor per dimension,
+    //   sum_k v_k prod_j exp(i f_j(g_j) o_kj h_j).
+    // The phase factors are computed once for every distinct offset o in
+    // dimension j and every lattice index g_j. Then, the elements are
+    // summed per offset in the first dimension, and a single matrix
+    // product with the phase table of the first dimension evaluates all
+    // rows of the lattice.
+    int d = dimension();
+    int nnz = m_stencil.nonZeros();
+    ArrayFi resolution = domain.resolution();
+    ArrayFd step_size = m_grid.step_size();
+    ArrayFd base_freq = domain.frequency(ArrayFi::Zero(d));
+    ArrayFd freq_step = 2.0 * pi / (step_size * resolution.cast<double>());
+
+    // slot[j][k] is the position of the offset of element k in the phase
+    // table of dimension j
+    vector<MatrixXcd> phases(d);
+    vector<vector<int> > slot(d, vector<int>(nnz));
+    for (int j = 0; j < d; ++j) {
+      vector<int> offsets;
+      for (int k = 0; k < nnz; ++k) {
+        int o = m_stencil[k].offset[j];
+        vector<int>::iterator it = std::find(offsets.begin(), offsets.end(), o);
+        slot[j][k] = it - offsets.begin();
+        if (it == offsets.end())
+          offsets.push_back(o);
+      }
+
+      phases[j].resize(resolution[j], offsets.size());
+      for (size_t o = 0; o < offsets.size(); ++o) {
+        for (int g = 0; g < resolution[j]; ++g) {
+          double arg = (base_freq[j] + g * freq_step[j])
+                       * offsets[o] * step_size[j];
+          phases[j](g, o) = exp(complex<double>(0, arg));
+        }
+      }
+    }
+
+    // weights(o, q) is the sum over the elements with the offset o in the
+    // first dimension, evaluated at row q of the lattice
+    int rows = resolution.prod() / resolution[0];
+    MatrixXcd weights = MatrixXcd::Zero(phases[0].cols(), rows);
+    SeparableWeights kernel(m_stencil, phases, slot, resolution, weights);
+    dispatch_dimension(d, kernel);
+
+    VectorXcd values(resolution.prod());
+    Map<MatrixXcd>(values.data(), resolution[0], rows).noalias()
+      = phases[0] * weights;
+
+    return values;
+  }
+
+  bool FoStencil::realCoefficients(const SamplingProperties& conf)
+  {
+    for (int k = 0; k < m_stencil.nonZeros(); ++k) {
+      if (imag(m_stencil[k].value) != 0.0)
+        return false;
+    }
+    return true;
+  }
+
+  size_t FoStencil::hash()
+  {
+    size_t seed = typeid(FoStencil).hash_code();
+    hash_combine(seed, hash_value(m_grid));
+    for (int i = 0; i < m_stencil.nonZeros(); ++i) {
+      hash_combine(seed, hash_value(m_stencil[i].offset));
+      hash_combine(seed, hash_value(m_stencil[i].value));
+    }
+    return seed;
+  }
+
+  bool FoStencil::equals(SymbolBuilder& other)
+  {
+    FoStencil* o = dynamic_cast<FoStencil*>(&other);
+    if (!o || !identical(m_grid, o->m_grid)
+        || m_stencil.nonZeros() != o->m_stencil.nonZeros())
+      return false;
+
+    for (int i = 0; i < m_stencil.nonZeros(); ++i) {
+      const StencilElement& a = m_stencil[i];
+      const StencilElement& b = o->m_stencil[i];
+      if (a.offset.rows() != b.offset.rows()
+          || (a.offset != b.offset).any() || a.value != b.value)
+        return false;
+    }
+
+    return true;
+  }
+
   void FoStencil::fill(SymbolClusterRef cluster,
                        ArrayFi base_index,
                        const DiscreteDomain& domain)
   {
-    ArrayFi zero = ArrayFi::Zero(dimension());
-    VectorFd frequency = domain.frequency(base_index, zero);
-    cluster(zero, zero) = symbolAt(frequency);
+    HarmonicClusters clusters = domain.harmonics();
+    NdRange cluster_indices = clusters.clusterIndices();
+    for (NdRange::iterator c = cluster_indices.begin();
+         c != cluster_indices.end(); ++c)
+    {
+      VectorFd frequency =
+        domain.frequency(clusters.globalIndex(base_index, *c));
+      cluster(*c, *c) = symbolAt(frequency);
+    }
   }
 
   complex<double> FoStencil::symbolAt(VectorFd frequency)
   {
+    // The terms of the offsets o and -o of a real symmetric stencil add
+    // up to 2 v cos(f.o h), hence, only the cosines are needed.
+    if (m_real_symmetric) {
+      double m = 0;
+      for (SparseStencil::iterator it = m_stencil.begin();
+          it != m_stencil.end(); ++it) {
+        VectorFd pos = it->offset.cast<double>() * m_grid.step_size();
+
+        m += real(it->value) * cos(frequency.dot(pos));
+      }
+
+      return m;
+    }
+
     complex<double> m = 0;
     for (SparseStencil::iterator it = m_stencil.begin();
         it != m_stencil.end(); ++it) {
@@ -38,20 +38,56 @@ namespace lfa {
       FoProperties properties();
 
       Symbol generate(const SamplingProperties& conf);
+      Symbol generateExpanded(const SamplingProperties& conf,
+                              ArrayFi factor);
+
+      /** Are all values of the stencil real? */
+      bool realCoefficients(const SamplingProperties& conf);
+
+      size_t hash();
+      bool equals(SymbolBuilder& other);
 
       /** Fill the ClusterSymbol given by cluster with the value of the symbol
-       * evaluated at the specified position. */
+       * evaluated at the specified position. The clusters of the domain may
+       * contain several harmonics. */
       void fill(SymbolClusterRef cluster,
                 ArrayFi base_index,
                 const DiscreteDomain& domain);
 
+      /** Evaluate the symbol at all frequencies of the domain. The values
+       * are ordered by the global index of the harmonics (see
+       * HarmonicClusters), with the first coordinate running fastest.
+       * The FFT is used if it is estimated to be faster, see preferFft. */
+      VectorXcd symbolOnLattice(const DiscreteDomain& domain);
+
+      /** Is the evaluation on a lattice of the given resolution by an FFT
+       * clearly faster than the separable evaluation? This is the case for
+       * wide stencils on resolutions without large prime factors. */
+      bool preferFft(ArrayFi resolution);
+
+      /** Evaluate the symbol on the lattice by separable phase tables. */
+      VectorXcd symbolOnLatticeSeparable(const DiscreteDomain& domain);
+      /** Evaluate the symbol on the lattice by an FFT. */
+      VectorXcd symbolOnLatticeFft(const DiscreteDomain& domain);
+
       /** Evaluate the symbol at the given frequency. */
       complex<double> symbolAt(VectorFd frequency);
 
+      /** Is the stencil real and symmetric (see
+       * SparseStencil::isRealSymmetric)? Then, the symbol is real and it
+       * is marked as real, such that it is computed in real arithmetic
+       * (see BdMatrix::isReal). Its entries are still stored as complex
+       * numbers. */
+      bool isRealSymmetric() const { return m_real_symmetric; }
+
       int dimension() { return m_grid.dimension(); }
+
+      const SparseStencil& stencil() const { return m_stencil; }
+      Grid grid() const { return m_grid; }
     private:
       SparseStencil m_stencil;
       Grid m_grid;
+      bool m_real_symmetric;
   };
 
 }
@@ -20,9 +20,48 @@
 #include "HarmonicClusters.h"
 #include "MathUtil.h"
 #include "SplitFrequencyDomain.h"
+#include "FixedDimension.h"
 
 namespace lfa {
 
+  namespace {
+
+    /** Computes the offsets (g * stride).sum() for all indices g of the
+     * given shape, in the order of NdRange. */
+    struct LinearOffsets {
+      LinearOffsets(const ArrayFi& shape,
+                    const ArrayFi& stride,
+                    vector<int>& offsets)
+        : shape(shape), stride(stride), offsets(offsets)
+      { }
+
+      template <int D>
+      void run()
+      {
+        typedef typename FixedIndex<D>::type Index;
+        const int d = fixed_dimension<D>(shape.size());
+
+        Index s = shape;
+        Index t = stride;
+        Index g = Index::Zero(d);
+        int n = s.prod();
+        offsets.resize(n);
+        for (int i = 0; i < n; ++i) {
+          int offset = 0;
+          for (int j = 0; j < d; ++j)
+            offset += g[j] * t[j];
+          offsets[i] = offset;
+          next_index<D>(g, s);
+        }
+      }
+
+      ArrayFi shape;
+      ArrayFi stride;
+      vector<int>& offsets;
+    };
+
+  }
+
   HarmonicClusters::HarmonicClusters(ArrayFi base_shape,
       ArrayFi cluster_shape)
     : m_base_shape(base_shape),
@@ -121,6 +160,30 @@ namespace lfa {
     return expanded.m_cluster_shape / m_cluster_shape;
   }
 
+  HarmonicIndexTable HarmonicClusters::indexTable() const
+  {
+    return HarmonicIndexTable(*this);
+  }
+
+  HarmonicIndexTable::HarmonicIndexTable(const HarmonicClusters& clusters)
+  {
+    // The linear index is linear in the coordinate, hence the global index
+    // b + base_shape * c splits into a base and a cluster part.
+    int d = clusters.dimension();
+    ArrayFi shape = clusters.shape();
+    ArrayFi stride(d);
+    for (int j = 0; j < d; ++j)
+      stride[j] = (j == 0) ? 1 : stride[j-1] * shape[j-1];
+
+    ArrayFi base_shape = clusters.baseIndices().shape();
+    LinearOffsets base(base_shape, stride, m_base_offsets);
+    dispatch_dimension(d, base);
+
+    LinearOffsets cluster(clusters.clusterShape(), base_shape * stride,
+                          m_cluster_offsets);
+    dispatch_dimension(d, cluster);
+  }
+
   HarmonicClusters make_harmonic_cluster(ArrayFi shape,
                                          const SplitFrequencyDomain &domain)
   {
@@ -28,6 +28,7 @@
 namespace lfa {
 
   class SplitFrequencyDomain;
+  class HarmonicIndexTable;
 
   /** Indexing for the harmonics.
    *
@@ -87,11 +88,43 @@ namespace lfa {
       ArrayFi expansionFactor(HarmonicClusters& expanded) const;
 
       ArrayFi clusterShape() const { return m_cluster_shape; }
+
+      /** Precomputed linear indices, see HarmonicIndexTable. */
+      HarmonicIndexTable indexTable() const;
     private:
       ArrayFi m_base_shape;
       ArrayFi m_cluster_shape;
   };
 
+  /** Linear global indices of harmonic clusters.
+   *
+   * For a base index b and a cluster index c, given as linear indices of
+   * baseIndices() and clusterIndices(), the linear index of the global
+   * index in globalIndices() is global(b, c) = baseOffset(b) +
+   * clusterOffset(c). The table is computed once, such that inner loops do
+   * not need to convert between coordinates and linear indices.
+   */
+  class HarmonicIndexTable {
+    public:
+      explicit HarmonicIndexTable(const HarmonicClusters& clusters);
+
+      int global(int b, int c) const {
+        return m_base_offsets[b] + m_cluster_offsets[c];
+      }
+
+      int baseOffset(int b) const { return m_base_offsets[b]; }
+      int clusterOffset(int c) const { return m_cluster_offsets[c]; }
+
+      const int* baseOffsets() const { return m_base_offsets.data(); }
+      const int* clusterOffsets() const { return m_cluster_offsets.data(); }
+
+      int baseSize() const { return m_base_offsets.size(); }
+      int clusterSize() const { return m_cluster_offsets.size(); }
+    private:
+      vector<int> m_base_offsets;
+      vector<int> m_cluster_offsets;
+  };
+
   HarmonicClusters make_harmonic_cluster(ArrayFi shape,
                                          const SplitFrequencyDomain &domain);
 }
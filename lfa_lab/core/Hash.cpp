@@ -0,0 +1,82 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "Hash.h"
+
+#include <functional>
+
+namespace lfa {
+
+  size_t hash_value(double x)
+  {
+    return std::hash<double>()(x);
+  }
+
+  size_t hash_value(complex<double> x)
+  {
+    size_t seed = hash_value(real(x));
+    hash_combine(seed, hash_value(imag(x)));
+    return seed;
+  }
+
+  size_t hash_value(const ArrayFi& a)
+  {
+    size_t seed = a.rows();
+    for (int i = 0; i < a.rows(); ++i) {
+      hash_combine(seed, std::hash<int>()(a(i)));
+    }
+    return seed;
+  }
+
+  size_t hash_value(const ArrayFd& a)
+  {
+    size_t seed = a.rows();
+    for (int i = 0; i < a.rows(); ++i) {
+      hash_combine(seed, hash_value(a(i)));
+    }
+    return seed;
+  }
+
+  size_t hash_value(const MatrixXcd& m)
+  {
+    size_t seed = m.rows();
+    hash_combine(seed, m.cols());
+    for (int j = 0; j < m.cols(); ++j) {
+      for (int i = 0; i < m.rows(); ++i) {
+        hash_combine(seed, hash_value(m(i,j)));
+      }
+    }
+    return seed;
+  }
+
+  size_t hash_value(const Grid& grid)
+  {
+    size_t seed = hash_value(grid.spacing());
+    hash_combine(seed, hash_value(grid.step_size()));
+    return seed;
+  }
+
+  bool identical(const Grid& a, const Grid& b)
+  {
+    return a.dimension() == b.dimension()
+      && a == b
+      && (a.step_size() == b.step_size()).all();
+  }
+
+}
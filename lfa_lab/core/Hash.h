@@ -0,0 +1,48 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_HASH_H
+#define LFA_HASH_H
+
+#include "Common.h"
+#include "Grid.h"
+
+namespace lfa {
+
+  /** Mix a hash value into a seed. */
+  inline void hash_combine(size_t& seed, size_t value)
+  {
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  }
+
+  size_t hash_value(double x);
+  size_t hash_value(complex<double> x);
+  size_t hash_value(const ArrayFi& a);
+  size_t hash_value(const ArrayFd& a);
+  size_t hash_value(const MatrixXcd& m);
+  size_t hash_value(const Grid& grid);
+
+  /** Do the grids have the same spacing and the same step size? In
+   * contrast to the comparison operator of Grid, this also compares the
+   * step size. */
+  bool identical(const Grid& a, const Grid& b);
+
+}
+
+#endif
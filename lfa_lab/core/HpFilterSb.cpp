@@ -21,10 +21,52 @@
 
 #include "MathUtil.h"
 #include "DiscreteDomain.h"
+#include "Hash.h"
+#include "FixedDimension.h"
+
+#include <typeinfo>
 
 
 namespace lfa {
 
+  namespace {
+
+    /** Marks the points of the lattice at which any coordinate is a high
+     * frequency. high[j][g] tells if the index g is a high frequency in
+     * dimension j. */
+    struct HighFrequencies {
+      HighFrequencies(const vector<vector<bool> >& high,
+                      const ArrayFi& resolution,
+                      vector<bool>& is_high)
+        : high(high), resolution(resolution), is_high(is_high)
+      { }
+
+      template <int D>
+      void run()
+      {
+        typedef typename FixedIndex<D>::type Index;
+        const int d = fixed_dimension<D>(resolution.size());
+
+        Index shape = resolution;
+        Index g = Index::Zero(d);
+        int n = shape.prod();
+        is_high.resize(n);
+        for (int i = 0; i < n; ++i) {
+          bool h = false;
+          for (int j = 0; j < d; ++j)
+            h = h || high[j][g[j]];
+          is_high[i] = h;
+          next_index<D>(g, shape);
+        }
+      }
+
+      const vector<vector<bool> >& high;
+      ArrayFi resolution;
+      vector<bool>& is_high;
+    };
+
+  }
+
   HpFilterSb::HpFilterSb(Grid fine_grid, Grid coarse_grid)
     :  m_grid(fine_grid),
     m_coarsing_factor(fine_grid.coarsening_factor(coarse_grid))
@@ -37,6 +79,12 @@ namespace lfa {
   }
 
   Symbol HpFilterSb::generate(const SamplingProperties& conf)
+  {
+    return generateExpanded(conf, ArrayFi::Ones(m_grid.dimension()));
+  }
+
+  vector<vector<bool> > HpFilterSb::highFrequencies(
+      const DiscreteDomain& domain)
   {
     /*
        x = low frequency
@@ -59,25 +107,95 @@ namespace lfa {
     ArrayFd upper_bound = (2 * m_coarsing_factor.cast<double>()
         - ArrayFd::Ones(d)) * block_size;
 
+    ArrayFi resolution = domain.harmonics().shape();
+    ArrayFd base_freq = domain.frequency(ArrayFi::Zero(d));
+    ArrayFd freq_step = 2.0 * pi / (domain.step_size()
+                                    * resolution.cast<double>());
+    vector<vector<bool> > high(d);
+    for (int j = 0; j < d; ++j) {
+      high[j].resize(resolution[j]);
+      for (int g = 0; g < resolution[j]; ++g) {
+        double freq = base_freq[j] + g * freq_step[j];
+        high[j][g] = (freq > lower_bound[j] && freq <= upper_bound[j]);
+      }
+    }
+
+    return high;
+  }
 
-    ArrayFi zero = ArrayFi::Zero(d);
+  Symbol HpFilterSb::generateExpanded(const SamplingProperties& conf,
+                                      ArrayFi factor)
+  {
+    int d = m_grid.dimension();
 
-    DiscreteDomain domain(properties().input(), conf);
+    // the symbol is diagonal, also if the clusters are merged
+    DiscreteDomain domain(SplitFrequencyDomain(m_grid, factor), conf);
     HarmonicClusters cluster = domain.harmonics();
     Symbol result(cluster, cluster);
 
-    NdRange bases = cluster.baseIndices();
-    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b)
-    {
-      ArrayFd freq = domain.frequency(*b, zero);
+    // classify the frequencies of every dimension, then every point of
+    // the frequency lattice once
+    ArrayFi resolution = cluster.shape();
+    vector<vector<bool> > high = highFrequencies(domain);
+
+    vector<bool> is_high;
+    HighFrequencies kernel(high, resolution, is_high);
+    dispatch_dimension(d, kernel);
+
+    HarmonicIndexTable table = cluster.indexTable();
+    BdMatrix& matrix = result.matrix();
+    for (int b = 0; b < table.baseSize(); ++b) {
+      for (int c = 0; c < table.clusterSize(); ++c) {
+        matrix(b, c, c) = (is_high[table.global(b, c)] ? 1 : 0);
+      }
+    }
+    matrix.setStructure(BdMatrix::Diagonal);
+    matrix.setReal(true);
+
+    return result;
+  }
 
-      bool is_high = (freq > lower_bound && freq <= upper_bound).any();
 
-      result.ref(*b, zero, zero) = (is_high ? 1 : 0);
+  bool HpFilterSb::realCoefficients(const SamplingProperties& conf)
+  {
+    // The filter is real, but a sampled frequency on the boundary of the
+    // low frequencies is classified differently than its negative.
+    ArrayFi shift;
+    if (!conf.conjugateShift(m_grid, shift))
+      return false;
+
+    DiscreteDomain domain(
+        SplitFrequencyDomain(m_grid, ArrayFi::Ones(m_grid.dimension())),
+        conf);
+    vector<vector<bool> > high = highFrequencies(domain);
+    for (size_t j = 0; j < high.size(); ++j) {
+      int n = high[j].size();
+      for (int g = 0; g < n; ++g) {
+        int mirrored = ((-(g + shift[j])) % n + n) % n;
+        if (high[j][g] != high[j][mirrored])
+          return false;
+      }
     }
 
-    return result;
+    return true;
   }
 
+  size_t HpFilterSb::hash()
+  {
+    size_t seed = typeid(HpFilterSb).hash_code();
+    hash_combine(seed, hash_value(m_grid));
+    hash_combine(seed, hash_value(m_coarsing_factor));
+    return seed;
+  }
+
+  bool HpFilterSb::equals(SymbolBuilder& other)
+  {
+    HpFilterSb* o = dynamic_cast<HpFilterSb*>(&other);
+    if (!o)
+      return false;
+
+    return identical(m_grid, o->m_grid)
+      && (m_coarsing_factor == o->m_coarsing_factor).all();
+  }
 
 }
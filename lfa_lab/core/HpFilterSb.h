@@ -22,6 +22,7 @@
 
 #include "Common.h"
 #include "SymbolBuilder.h"
+#include "DiscreteDomain.h"
 
 namespace lfa {
 
@@ -32,7 +33,20 @@ namespace lfa {
 
       virtual FoProperties properties();
       virtual Symbol generate(const SamplingProperties& conf);
+      virtual Symbol generateExpanded(const SamplingProperties& conf,
+                                      ArrayFi factor);
+
+      /** Is every sampled frequency classified like its negative? */
+      virtual bool realCoefficients(const SamplingProperties& conf);
+
+      virtual size_t hash();
+      virtual bool equals(SymbolBuilder& other);
     private:
+      /** Classify the frequencies of the domain in every dimension. The
+       * entry [j][g] tells if the lattice index g is a high frequency in
+       * dimension j. */
+      vector<vector<bool> > highFrequencies(const DiscreteDomain& domain);
+
       Grid m_grid;
       ArrayFi m_coarsing_factor;
   };
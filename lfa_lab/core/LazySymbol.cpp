@@ -0,0 +1,176 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "LazySymbol.h"
+#include "Parallel.h"
+#include "MathUtil.h"
+
+namespace lfa {
+
+  LazySymbol::LazySymbol(Expression expr, SamplingProperties conf)
+    : m_expr(expr),
+      m_evaluator(expr.simplified().builder()),
+      m_conf(conf)
+  {
+    // The smallest resolution that can sample the expression has exactly
+    // one cluster.
+    FoProperties props = m_expr.properties();
+    m_cluster_resolution =
+      props.adjustResolution(ArrayFi::Ones(props.dimension()));
+
+    ArrayFi rem = conf.finest_resolution().binaryExpr(
+        m_cluster_resolution, std::modulus<int>());
+    if (!rem.isZero())
+      throw logic_error("The resolution cannot be used to sample the "
+                        "expression.");
+
+    m_bases = NdRange(conf.finest_resolution() / m_cluster_resolution);
+
+    m_conjugate_symmetric =
+      conf.conjugateShift(props.outputGrid(), m_conjugate_shift)
+      && has_real_coefficients(*expr.simplified().builder(), conf);
+  }
+
+  ArrayFi LazySymbol::conjugateBase(ArrayFi base) const
+  {
+    if (!m_conjugate_symmetric)
+      throw logic_error("The symbol is not conjugate symmetric.");
+    if (!m_bases.inRange(base))
+      throw out_of_range("Invalid base index.");
+
+    // The frequency of the lattice index g is the negative of the one of
+    // -(g + s). The cluster of the base index b contains the indices
+    // b + n*k, hence, its negative frequencies belong to the base index
+    // -(b + s) mod n, where n is the number of bases.
+    ArrayFi n = m_bases.shape();
+    ArrayFi conj = (-(base + m_conjugate_shift))
+      .binaryExpr(n, std::modulus<int>());
+    return (conj < 0).select(conj + n, conj);
+  }
+
+  bool LazySymbol::isFundamental(int i) const
+  {
+    if (!m_conjugate_symmetric)
+      return true;
+
+    return i <= m_bases.indexOf(conjugateBase(m_bases.coordOf(i)));
+  }
+
+  SamplingProperties LazySymbol::clusterSampling(ArrayFi base) const
+  {
+    // The cluster of base index b contains the frequencies
+    //   theta + (b + n*g) * 2 pi / (h * N),  g = 0, ..., c-1,
+    // where N is the resolution, n = N / c the number of bases, and c the
+    // cluster resolution. These are the frequencies of the cluster
+    // resolution, shifted by b * 2 pi / (h * N).
+    ArrayFd h = m_expr.properties().outputGrid().finestStepSize();
+    ArrayFd shift = base.cast<double>() * 2.0 * pi
+      / (h * m_conf.finest_resolution().cast<double>());
+
+    return SamplingProperties(m_cluster_resolution,
+                              m_conf.base_frequency() + shift);
+  }
+
+  Symbol LazySymbol::cluster(ArrayFi base) const
+  {
+    if (!m_bases.inRange(base))
+      throw out_of_range("Invalid base index.");
+
+    return m_evaluator.evaluate(clusterSampling(base));
+  }
+
+  double LazySymbol::spectral_radius() const
+  {
+    double radius = 0;
+    ParallelErrors errors;
+
+    #pragma omp parallel for reduction(max:radius) schedule(dynamic)
+    for (int i = 0; i < m_bases.size(); ++i) {
+      if (!isFundamental(i))
+        continue;
+
+      try {
+        radius = std::max(radius,
+                          cluster(m_bases.coordOf(i)).spectral_radius());
+      } catch (...) {
+        errors.capture();
+      }
+    }
+    errors.rethrow();
+
+    return radius;
+  }
+
+  double LazySymbol::spectral_norm() const
+  {
+    double norm = 0;
+    ParallelErrors errors;
+
+    #pragma omp parallel for reduction(max:norm) schedule(dynamic)
+    for (int i = 0; i < m_bases.size(); ++i) {
+      if (!isFundamental(i))
+        continue;
+
+      try {
+        norm = std::max(norm, cluster(m_bases.coordOf(i)).spectral_norm());
+      } catch (...) {
+        errors.capture();
+      }
+    }
+    errors.rethrow();
+
+    return norm;
+  }
+
+  VectorXcd LazySymbol::eigenvalues() const
+  {
+    FoProperties props = m_expr.properties();
+    if (!props.rectangular())
+      throw logic_error("Expecting a square matrix.");
+
+    // every cluster contributes the same number of eigenvalues
+    int n = props.output().clusterShape().prod();
+    VectorXcd result(n * m_bases.size());
+    ParallelErrors errors;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < m_bases.size(); ++i) {
+      if (!isFundamental(i))
+        continue;
+
+      try {
+        ArrayFi base = m_bases.coordOf(i);
+        result.segment(i * n, n) = cluster(base).eigenvalues();
+
+        // the eigenvalues of the conjugate cluster
+        if (m_conjugate_symmetric) {
+          int j = m_bases.indexOf(conjugateBase(base));
+          if (j != i)
+            result.segment(j * n, n) = result.segment(i * n, n).conjugate();
+        }
+      } catch (...) {
+        errors.capture();
+      }
+    }
+    errors.rethrow();
+
+    return result;
+  }
+
+}
@@ -0,0 +1,88 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_LAZY_SYMBOL_H
+#define LFA_LAZY_SYMBOL_H
+
+#include "Common.h"
+#include "Expression.h"
+#include "DagEvaluator.h"
+#include "NdRange.h"
+
+namespace lfa {
+
+  /** The symbol of an expression that is evaluated one cluster at a time.
+   *
+   * The symbol of the whole expression is never stored. Instead, for every
+   * base index, the expression is sampled only at the frequencies of the
+   * corresponding cluster. The resulting block is reduced and discarded.
+   * Hence, the required memory does not depend on the resolution.
+   *
+   * If the expression has real coefficients and the sampling contains the
+   * negative of every frequency, the cluster of the conjugate base index
+   * (see conjugateBase) has the complex conjugate eigenvalues and the same
+   * norms. Then, only half of the clusters are evaluated.
+   */
+  class LazySymbol {
+    public:
+      LazySymbol(Expression expr, SamplingProperties conf);
+
+      /** The base indices of the symbol. */
+      NdRange baseIndices() const { return m_bases; }
+
+      /** The symbol restricted to the cluster of the given base index. The
+       * result consists of a single block. */
+      Symbol cluster(ArrayFi base) const;
+
+      /** Do the clusters come in complex conjugate pairs? */
+      bool isConjugateSymmetric() const { return m_conjugate_symmetric; }
+
+      /** The base index whose cluster contains the negative frequencies of
+       * the cluster of the given base index. Only available, if the
+       * symbol is conjugate symmetric. */
+      ArrayFi conjugateBase(ArrayFi base) const;
+
+      double spectral_radius() const;
+      double spectral_norm() const;
+
+      VectorXcd eigenvalues() const;
+    private:
+      /** The sampling that contains exactly the frequencies of the cluster
+       * with the given base index. */
+      SamplingProperties clusterSampling(ArrayFi base) const;
+
+      /** Is the cluster of the linear base index i evaluated? If the symbol
+       * is conjugate symmetric, only the cluster of the smaller linear
+       * index of a conjugate pair is. */
+      bool isFundamental(int i) const;
+
+      Expression m_expr;
+      DagEvaluator m_evaluator;
+      SamplingProperties m_conf;
+      ArrayFi m_cluster_resolution;
+      NdRange m_bases;
+      bool m_conjugate_symmetric;
+      /** The shift s of the lattice indices, see
+       * SamplingProperties::conjugateShift. */
+      ArrayFi m_conjugate_shift;
+  };
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+  vim: set filetype=cpp:
+*/
+
+%feature("autodoc", "The symbol of an expression that is evaluated one
+frequency cluster at a time. The symbol is never stored as a
+whole.") LazySymbol;
+%feature("autodoc", "The symbol restricted to the cluster of the given
+base index.") LazySymbol::cluster;
+%feature("autodoc", "Do the clusters come in complex conjugate pairs? Then,
+only half of them are evaluated.") LazySymbol::isConjugateSymmetric;
+%feature("autodoc", "The base index of the cluster that contains the
+negative frequencies of the given one.") LazySymbol::conjugateBase;
+%feature("autodoc", "The spectral radius of the symbol.")
+LazySymbol::spectral_radius;
+%feature("autodoc", "The (spectral) norm of the symbol.")
+LazySymbol::spectral_norm;
+%feature("autodoc", "The eigenvalues of the symbol as a vector.")
+LazySymbol::eigenvalues;
+class LazySymbol {
+  public:
+    LazySymbol(Expression expr, SamplingProperties conf);
+
+    NdRange baseIndices() const;
+    Symbol cluster(ArrayFi base) const;
+
+    bool isConjugateSymmetric() const;
+    ArrayFi conjugateBase(ArrayFi base) const;
+
+    double spectral_radius() const;
+    double spectral_norm() const;
+
+    VectorXcd eigenvalues() const;
+};
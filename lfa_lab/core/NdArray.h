@@ -44,6 +44,14 @@ namespace lfa {
         return m_elements[m_grid.indexOf(pos)];
       }
 
+      /** Access by the linear index, see NdRange::indexOf. */
+      T& operator[] (int i) { return m_elements[i]; }
+      const T& operator[] (int i) const { return m_elements[i]; }
+
+      /** The elements, ordered by the linear index. */
+      T* data() { return m_elements.data(); }
+      const T* data() const { return m_elements.data(); }
+
       bool index_in_range(const ArrayFi& pos) const {
         return m_grid.inRange(pos);
       }
@@ -62,6 +62,21 @@ class NdRange {
             return num;
         }
 
+        /** The coordinate of the element with the given linear index. This
+         * is the inverse of indexOf. */
+        ArrayFi coordOf(int index) const {
+            assert(0 <= index && index < m_shape.prod());
+
+            ArrayFi coord(dimension());
+            for (int d = 0; d < dimension(); ++d)
+            {
+                coord[d] = index % m_shape[d];
+                index /= m_shape[d];
+            }
+
+            return coord;
+        }
+
         bool inRange(ArrayFi coord) const {
             assert(coord.rows() == dimension());
 
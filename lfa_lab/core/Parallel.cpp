@@ -0,0 +1,58 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "Parallel.h"
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif
+
+namespace lfa {
+
+void set_num_threads(int n)
+{
+#ifdef WITH_OPENMP
+    if (n < 1) {
+        n = omp_get_num_procs();
+    }
+    omp_set_num_threads(n);
+#endif
+}
+
+int num_threads()
+{
+#ifdef WITH_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+void ParallelErrors::capture()
+{
+    #pragma omp critical(lfa_parallel_errors)
+    {
+        if (!m_error) {
+            m_error = std::current_exception();
+        }
+    }
+}
+
+}
+
@@ -0,0 +1,66 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_PARALLEL_H
+#define LFA_PARALLEL_H
+
+#include "Common.h"
+
+#include <exception>
+
+namespace lfa {
+
+  /** Set the number of threads used for the block loops. For values smaller
+   * than one, all available processors are used. Without OpenMP support this
+   * function does nothing. */
+  void set_num_threads(int n);
+
+  /** The number of threads used for the block loops. */
+  int num_threads();
+
+  /** Collects the first error that occured inside a parallel loop.
+   *
+   * Exceptions must not leave an OpenMP parallel region. Hence, they are
+   * captured inside the loop and rethrown, once the loop has finished. The
+   * rethrown exception is the captured one, i.e., it keeps its type.
+   */
+  class ParallelErrors {
+    public:
+      ParallelErrors() { }
+
+      /** Store the exception that is currently handled, unless another
+       * exception has been stored before. Must be called from a catch
+       * block. */
+      void capture();
+
+      bool failed() const { return bool(m_error); }
+
+      /** Throw the captured exception, if there is one. */
+      void rethrow() const {
+        if (m_error) {
+          std::rethrow_exception(m_error);
+        }
+      }
+    private:
+      std::exception_ptr m_error;
+  };
+
+}
+
+#endif
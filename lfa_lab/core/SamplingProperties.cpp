@@ -38,5 +38,26 @@ namespace lfa {
 
   }
 
+  bool SamplingProperties::conjugateShift(Grid grid, ArrayFi& shift) const
+  {
+    ArrayFd step = 2.0 * pi / (grid.finestStepSize()
+                               * m_finest_resolution.cast<double>());
+    ArrayFd s = 2.0 * m_base_frequency / step;
+    ArrayFd rounded = s.round();
+
+    if (((s - rounded).abs() > 1e-8).any())
+      return false;
+
+    shift = rounded.cast<int>();
+    return true;
+  }
+
+  bool SamplingProperties::operator== (const SamplingProperties& other) const
+  {
+    return m_finest_resolution.rows() == other.m_finest_resolution.rows()
+      && (m_finest_resolution == other.m_finest_resolution).all()
+      && (m_base_frequency == other.m_base_frequency).all();
+  }
+
 }
 
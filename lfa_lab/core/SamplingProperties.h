@@ -36,6 +36,20 @@ namespace lfa {
       /** Resolution on the finest grid. */
       const ArrayFi& finest_resolution() const { return m_finest_resolution; }
       const ArrayFd& base_frequency() const { return m_base_frequency; }
+
+      /** Does the sampling contain the negative of every sampled frequency
+       * (modulo 2 pi / h)? This is the case iff twice the base frequency
+       * is a multiple s of the frequency step. Then, the lattice index g
+       * and the index -(g + s) modulo the resolution (of any grid) have
+       * negative frequencies, and shift is set to s.
+       * @param grid Is an arbitrary grid from the grid hierarchy.
+       */
+      bool conjugateShift(Grid grid, ArrayFi& shift) const;
+
+      bool operator== (const SamplingProperties& other) const;
+      bool operator!= (const SamplingProperties& other) const {
+        return !(*this == other);
+      }
     private:
       ArrayFi m_finest_resolution; /// < The resolution on the finest grid.
       ArrayFd m_base_frequency;
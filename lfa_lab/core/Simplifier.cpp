@@ -0,0 +1,599 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "Simplifier.h"
+#include "ExpressionSb.h"
+#include "FoStencil.h"
+#include "BlockSb.h"
+#include "Hash.h"
+#include "MathUtil.h"
+
+#include <limits>
+
+namespace lfa {
+
+  namespace {
+
+    /** Is the operator square with clusters of size one? Only then it can
+     * be replaced by a ZeroSb. */
+    bool is_unit_square(const FoProperties& props)
+    {
+      SplitFrequencyDomain unit(props.outputGrid());
+      return props.output() == unit && props.input() == unit;
+    }
+
+    /** Is the builder a multiple of the identity? */
+    bool as_multiple_of_identity(SymbolBuilderPtr builder,
+                                 complex<double>& scalar,
+                                 Grid& grid)
+    {
+      if (IdentitySb* id = dynamic_cast<IdentitySb*>(builder.get())) {
+        scalar = 1;
+        grid = id->grid();
+        return true;
+      }
+
+      if (FoStencil* st = dynamic_cast<FoStencil*>(builder.get())) {
+        const SparseStencil& stencil = st->stencil();
+        scalar = 0;
+        for (int i = 0; i < stencil.nonZeros(); ++i) {
+          if ((stencil[i].offset != 0).any())
+            return false;
+          scalar += stencil[i].value;
+        }
+        grid = st->grid();
+        return true;
+      }
+
+      if (ScaledSb* sc = dynamic_cast<ScaledSb*>(builder.get())) {
+        if (!as_multiple_of_identity(sc->op(), scalar, grid))
+          return false;
+        scalar *= sc->scalar();
+        return true;
+      }
+
+      return false;
+    }
+
+    /** The stencil of the builder, if it is given by a stencil. */
+    bool as_stencil(SymbolBuilderPtr builder,
+                    SparseStencil& stencil,
+                    Grid& grid)
+    {
+      if (IdentitySb* id = dynamic_cast<IdentitySb*>(builder.get())) {
+        grid = id->grid();
+        stencil = SparseStencil();
+        stencil.append(ArrayFi::Zero(grid.dimension()), 1);
+        return true;
+      }
+
+      if (FoStencil* st = dynamic_cast<FoStencil*>(builder.get())) {
+        grid = st->grid();
+        stencil = st->stencil();
+        return true;
+      }
+
+      return false;
+    }
+
+    /** Split the builder into a scalar and an operator. */
+    SymbolBuilderPtr split_scalar(SymbolBuilderPtr builder,
+                                  complex<double>& scalar)
+    {
+      if (ScaledSb* sc = dynamic_cast<ScaledSb*>(builder.get())) {
+        scalar = sc->scalar();
+        return sc->op();
+      }
+
+      scalar = 1;
+      return builder;
+    }
+
+    /** Builds the symbol of the stencil. Stencils without entries are
+     * replaced by a ZeroSb. */
+    SymbolBuilderPtr stencil_builder(const SparseStencil& stencil,
+                                     Grid grid)
+    {
+      if (stencil.nonZeros() == 0)
+        return SymbolBuilderPtr(new ZeroSb(grid));
+      return SymbolBuilderPtr(new FoStencil(stencil, grid));
+    }
+
+    /** Add the element to the stencil, merging equal offsets. */
+    void accumulate(SparseStencil& stencil, const StencilElement& element)
+    {
+      for (int i = 0; i < stencil.nonZeros(); ++i) {
+        if ((stencil[i].offset == element.offset).all()) {
+          stencil[i].value += element.value;
+          return;
+        }
+      }
+      stencil.append(element.offset, element.value);
+    }
+
+    SparseStencil stencil_sum(const SparseStencil& s,
+                              const SparseStencil& t)
+    {
+      SparseStencil merged;
+      for (int i = 0; i < s.nonZeros(); ++i)
+        accumulate(merged, s[i]);
+      for (int i = 0; i < t.nonZeros(); ++i)
+        accumulate(merged, t[i]);
+
+      SparseStencil result;
+      for (int i = 0; i < merged.nonZeros(); ++i) {
+        if (merged[i].value != 0.0)
+          result.append(merged[i].offset, merged[i].value);
+      }
+      return result;
+    }
+
+    SparseStencil stencil_scaled(complex<double> scalar,
+                                 const SparseStencil& s)
+    {
+      SparseStencil result;
+      for (int i = 0; i < s.nonZeros(); ++i)
+        result.append(s[i].offset, scalar * s[i].value);
+      return result;
+    }
+
+    /** The symbol of the adjoint is the complex conjugate. */
+    SparseStencil stencil_adjoint(const SparseStencil& s)
+    {
+      SparseStencil result;
+      for (int i = 0; i < s.nonZeros(); ++i)
+        result.append(-s[i].offset, std::conj(s[i].value));
+      return result;
+    }
+
+    /** The product of two operators. The product with an inverse is
+     * computed by solving with the inverted operator. */
+    SymbolBuilderPtr product_builder(SymbolBuilderPtr lhs,
+                                     SymbolBuilderPtr rhs)
+    {
+      if (InverseSb* inv = dynamic_cast<InverseSb*>(lhs.get()))
+        return SymbolBuilderPtr(new SolveSb(inv->op(), rhs));
+
+      return SymbolBuilderPtr(new ProductSb(lhs, rhs));
+    }
+
+    /** Multiply the operators i to j in the order given by split. */
+    SymbolBuilderPtr build_chain(const vector<SymbolBuilderPtr>& ops,
+                                 const vector<vector<int> >& split,
+                                 int i, int j)
+    {
+      if (i == j)
+        return ops[i];
+
+      int k = split[i][j];
+      SymbolBuilderPtr lhs = build_chain(ops, split, i, k);
+      SymbolBuilderPtr rhs = build_chain(ops, split, k+1, j);
+      return product_builder(lhs, rhs);
+    }
+
+  }
+
+  SymbolBuilderPtr Simplifier::simplify(SymbolBuilderPtr root)
+  {
+    countUses(root);
+    return rewrite(root);
+  }
+
+  void Simplifier::countUses(SymbolBuilderPtr builder)
+  {
+    vector<SymbolBuilderPtr> deps = builder->dependencies();
+    for (size_t i = 0; i < deps.size(); ++i) {
+      if (m_uses[deps[i].get()]++ == 0)
+        countUses(deps[i]);
+    }
+  }
+
+  SymbolBuilderPtr Simplifier::rewrite(SymbolBuilderPtr builder)
+  {
+    std::map<SymbolBuilder*, SymbolBuilderPtr>::iterator it
+      = m_simplified.find(builder.get());
+    if (it != m_simplified.end())
+      return it->second;
+
+    SymbolBuilderPtr result = builder;
+    SymbolBuilder* b = builder.get();
+
+    if (SumSb* sum_sb = dynamic_cast<SumSb*>(b)) {
+      result = sum(rewrite(sum_sb->lhs()), rewrite(sum_sb->rhs()));
+    }
+    else if (ProductSb* prod_sb = dynamic_cast<ProductSb*>(b)) {
+      vector<SymbolBuilderPtr> factors;
+      collectFactors(*prod_sb, factors);
+      result = chain(factors);
+    }
+    else if (ScaledSb* scaled_sb = dynamic_cast<ScaledSb*>(b)) {
+      result = scaled(scaled_sb->scalar(), rewrite(scaled_sb->op()));
+    }
+    else if (ParameterSb* param_sb = dynamic_cast<ParameterSb*>(b)) {
+      result = parameter(builder, rewrite(param_sb->op()));
+    }
+    else if (PowerSb* power_sb = dynamic_cast<PowerSb*>(b)) {
+      result = power(rewrite(power_sb->op()), power_sb->exponent());
+    }
+    else if (PolynomialSb* poly_sb = dynamic_cast<PolynomialSb*>(b)) {
+      SymbolBuilderPtr op = rewrite(poly_sb->op());
+      if (op != poly_sb->op())
+        result.reset(new PolynomialSb(poly_sb->coefficients(), op));
+    }
+    else if (InverseSb* inverse_sb = dynamic_cast<InverseSb*>(b)) {
+      result = inverse(rewrite(inverse_sb->op()));
+    }
+    else if (AdjointSb* adjoint_sb = dynamic_cast<AdjointSb*>(b)) {
+      result = adjoint(rewrite(adjoint_sb->op()));
+    }
+    else if (BlockSb* block_sb = dynamic_cast<BlockSb*>(b)) {
+      const NdArray<SymbolBuilderPtr>& scalars = block_sb->scalarBuilders();
+      if (scalars.dimension() > 0) {
+        NdArray<SymbolBuilderPtr> simplified(scalars.shape());
+        bool changed = false;
+
+        NdRange indices = scalars.indices();
+        for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p)
+        {
+          simplified(*p) = rewrite(scalars(*p));
+          changed = changed || simplified(*p) != scalars(*p);
+        }
+
+        if (changed)
+          result.reset(new BlockSb(block_sb->grid(), simplified));
+      }
+    }
+
+    m_simplified[b] = result;
+    return result;
+  }
+
+  void Simplifier::collectFactors(ProductSb& product,
+                                  vector<SymbolBuilderPtr>& factors)
+  {
+    SymbolBuilderPtr operands[] = { product.lhs(), product.rhs() };
+    for (int i = 0; i < 2; ++i) {
+      ProductSb* inner = dynamic_cast<ProductSb*>(operands[i].get());
+      if (inner && m_uses[inner] == 1)
+        collectFactors(*inner, factors);
+      else
+        factors.push_back(rewrite(operands[i]));
+    }
+  }
+
+  SymbolBuilderPtr Simplifier::chain(const vector<SymbolBuilderPtr>& factors)
+  {
+    // Collect the scalars and the multiples of the identity
+    complex<double> scalar = 1;
+    vector<SymbolBuilderPtr> ops;
+    bool has_zero = false;
+    Grid grid;
+    for (size_t i = 0; i < factors.size(); ++i) {
+      complex<double> s;
+      SymbolBuilderPtr op = split_scalar(factors[i], s);
+      scalar *= s;
+
+      if (as_multiple_of_identity(op, s, grid)) {
+        scalar *= s;
+        continue;
+      }
+
+      has_zero = has_zero || dynamic_cast<ZeroSb*>(op.get());
+      ops.push_back(op);
+    }
+
+    if (ops.empty())
+      return scaled(scalar, SymbolBuilderPtr(new IdentitySb(grid)));
+
+    int n = ops.size();
+    vector<FoProperties> props(n);
+    for (int i = 0; i < n; ++i) {
+      props[i] = ops[i]->properties();
+    }
+
+    if (has_zero) {
+      FoProperties result = props[0];
+      for (int i = 1; i < n; ++i) {
+        result = result * props[i];
+      }
+      if (is_unit_square(result))
+        return SymbolBuilderPtr(new ZeroSb(result.outputGrid()));
+    }
+
+    // Applying the scalar to a stencil is free.
+    if (scalar != 1.0) {
+      for (int i = 0; i < n; ++i) {
+        if (dynamic_cast<FoStencil*>(ops[i].get())) {
+          ops[i] = scaled(scalar, ops[i]);
+          scalar = 1;
+          break;
+        }
+      }
+    }
+
+    // Matrix chain ordering. The operators i to j are multiplied with
+    // cost[i][j] operations, the last multiplication being split after
+    // split[i][j].
+    vector<vector<FoProperties> > chain_props(n, vector<FoProperties>(n));
+    vector<vector<double> > cost(n, vector<double>(n, 0.0));
+    vector<vector<int> > split(n, vector<int>(n, 0));
+    for (int i = 0; i < n; ++i) {
+      chain_props[i][i] = props[i];
+    }
+    for (int length = 2; length <= n; ++length) {
+      for (int i = 0; i + length <= n; ++i) {
+        int j = i + length - 1;
+        cost[i][j] = std::numeric_limits<double>::infinity();
+        for (int k = i; k < j; ++k) {
+          double c = cost[i][k] + cost[k+1][j]
+            + product_cost(chain_props[i][k], chain_props[k+1][j]);
+          if (c < cost[i][j]) {
+            cost[i][j] = c;
+            split[i][j] = k;
+          }
+        }
+        int k = split[i][j];
+        chain_props[i][j] = chain_props[i][k] * chain_props[k+1][j];
+      }
+    }
+
+    return scaled(scalar, build_chain(ops, split, 0, n-1));
+  }
+
+  SymbolBuilderPtr Simplifier::sum(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs)
+  {
+    if (dynamic_cast<ZeroSb*>(lhs.get()))
+      return rhs;
+    if (dynamic_cast<ZeroSb*>(rhs.get()))
+      return lhs;
+
+    // a*A + b*A = (a+b)*A
+    complex<double> a, b;
+    SymbolBuilderPtr lhs_op = split_scalar(lhs, a);
+    SymbolBuilderPtr rhs_op = split_scalar(rhs, b);
+    if (structurally_equal(*lhs_op, *rhs_op))
+      return scaled(a + b, lhs_op);
+
+    SparseStencil s, t;
+    Grid s_grid, t_grid;
+    if (as_stencil(lhs, s, s_grid) && as_stencil(rhs, t, t_grid)
+        && identical(s_grid, t_grid))
+    {
+      return stencil_builder(stencil_sum(s, t), s_grid);
+    }
+
+    return SymbolBuilderPtr(new SumSb(lhs, rhs));
+  }
+
+  SymbolBuilderPtr Simplifier::product(SymbolBuilderPtr lhs,
+                                       SymbolBuilderPtr rhs)
+  {
+    complex<double> scalar;
+    Grid grid;
+    if (as_multiple_of_identity(lhs, scalar, grid))
+      return scaled(scalar, rhs);
+    if (as_multiple_of_identity(rhs, scalar, grid))
+      return scaled(scalar, lhs);
+
+    if (dynamic_cast<ZeroSb*>(lhs.get()) || dynamic_cast<ZeroSb*>(rhs.get()))
+    {
+      FoProperties props = lhs->properties() * rhs->properties();
+      if (is_unit_square(props))
+        return SymbolBuilderPtr(new ZeroSb(props.outputGrid()));
+    }
+
+    // pull the scalars out, such that they can be folded
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(lhs.get()))
+      return scaled(sc->scalar(), product(sc->op(), rhs));
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(rhs.get()))
+      return scaled(sc->scalar(), product(lhs, sc->op()));
+
+    return product_builder(lhs, rhs);
+  }
+
+  SymbolBuilderPtr Simplifier::scaled(complex<double> scalar,
+                                      SymbolBuilderPtr op)
+  {
+    if (scalar == 1.0 || dynamic_cast<ZeroSb*>(op.get()))
+      return op;
+
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(op.get()))
+      return scaled(scalar * sc->scalar(), sc->op());
+
+    if (scalar == 0.0) {
+      FoProperties props = op->properties();
+      if (is_unit_square(props))
+        return SymbolBuilderPtr(new ZeroSb(props.outputGrid()));
+    }
+
+    if (FoStencil* st = dynamic_cast<FoStencil*>(op.get()))
+      return stencil_builder(stencil_scaled(scalar, st->stencil()),
+                             st->grid());
+
+    return SymbolBuilderPtr(new ScaledSb(scalar, op));
+  }
+
+  SymbolBuilderPtr Simplifier::parameter(SymbolBuilderPtr builder,
+                                         SymbolBuilderPtr op)
+  {
+    ParameterSb& param = static_cast<ParameterSb&>(*builder);
+
+    if (dynamic_cast<ZeroSb*>(op.get()))
+      return op;
+
+    // Keep the scalars outside, such that they can be folded further.
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(op.get())) {
+      return scaled(sc->scalar(),
+                    SymbolBuilderPtr(new ParameterSb(param.name(),
+                                                     param.value(),
+                                                     sc->op())));
+    }
+
+    if (op == param.op())
+      return builder;
+
+    return SymbolBuilderPtr(new ParameterSb(param.name(), param.value(), op));
+  }
+
+  SymbolBuilderPtr Simplifier::power(SymbolBuilderPtr op, int exponent)
+  {
+    if (exponent == 0)
+      return SymbolBuilderPtr(new IdentitySb(op->properties().outputGrid()));
+
+    if (exponent == 1 || dynamic_cast<IdentitySb*>(op.get())
+        || dynamic_cast<ZeroSb*>(op.get()))
+    {
+      return op;
+    }
+
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(op.get()))
+      return scaled(std::pow(sc->scalar(), exponent),
+                    power(sc->op(), exponent));
+
+    return SymbolBuilderPtr(new PowerSb(op, exponent));
+  }
+
+  SymbolBuilderPtr Simplifier::inverse(SymbolBuilderPtr op)
+  {
+    if (InverseSb* inv = dynamic_cast<InverseSb*>(op.get()))
+      return inv->op();
+
+    if (dynamic_cast<IdentitySb*>(op.get()))
+      return op;
+
+    complex<double> scalar;
+    Grid grid;
+    if (as_multiple_of_identity(op, scalar, grid) && scalar != 0.0) {
+      SparseStencil diagonal;
+      diagonal.append(ArrayFi::Zero(grid.dimension()), 1.0 / scalar);
+      return SymbolBuilderPtr(new FoStencil(diagonal, grid));
+    }
+
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(op.get())) {
+      if (sc->scalar() != 0.0)
+        return scaled(1.0 / sc->scalar(), inverse(sc->op()));
+    }
+
+    return SymbolBuilderPtr(new InverseSb(op));
+  }
+
+  SymbolBuilderPtr Simplifier::adjoint(SymbolBuilderPtr op)
+  {
+    std::map<SymbolBuilder*, pair<SymbolBuilderPtr, SymbolBuilderPtr> >
+      ::iterator it = m_adjoints.find(op.get());
+    if (it != m_adjoints.end())
+      return it->second.second;
+
+    SymbolBuilderPtr result = pushAdjoint(op);
+    m_adjoints[op.get()] = std::make_pair(op, result);
+    return result;
+  }
+
+  SymbolBuilderPtr Simplifier::pushAdjoint(SymbolBuilderPtr op)
+  {
+    SymbolBuilder* b = op.get();
+
+    if (AdjointSb* adj = dynamic_cast<AdjointSb*>(b))
+      return adj->op();
+
+    if (dynamic_cast<IdentitySb*>(b) || dynamic_cast<ZeroSb*>(b))
+      return op;
+
+    if (FoStencil* st = dynamic_cast<FoStencil*>(b))
+      return stencil_builder(stencil_adjoint(st->stencil()), st->grid());
+
+    if (ScaledSb* sc = dynamic_cast<ScaledSb*>(b))
+      return scaled(std::conj(sc->scalar()), adjoint(sc->op()));
+
+    // Only push the adjoint further down, if it does not create more
+    // AdjointSb nodes.
+    if (absorbsAdjoint(op)) {
+      if (SumSb* s = dynamic_cast<SumSb*>(b))
+        return sum(adjoint(s->lhs()), adjoint(s->rhs()));
+      if (ProductSb* p = dynamic_cast<ProductSb*>(b))
+        return product(adjoint(p->rhs()), adjoint(p->lhs()));
+      if (InverseSb* inv = dynamic_cast<InverseSb*>(b))
+        return inverse(adjoint(inv->op()));
+    }
+
+    return SymbolBuilderPtr(new AdjointSb(op));
+  }
+
+  bool Simplifier::absorbsAdjoint(SymbolBuilderPtr builder)
+  {
+    SymbolBuilder* b = builder.get();
+
+    std::map<SymbolBuilder*, pair<SymbolBuilderPtr, bool> >::iterator it
+      = m_absorbs_adjoint.find(b);
+    if (it != m_absorbs_adjoint.end())
+      return it->second.second;
+
+    bool absorbs = false;
+    if (dynamic_cast<AdjointSb*>(b) || dynamic_cast<IdentitySb*>(b)
+        || dynamic_cast<ZeroSb*>(b) || dynamic_cast<FoStencil*>(b))
+    {
+      absorbs = true;
+    }
+    else if (ScaledSb* sc = dynamic_cast<ScaledSb*>(b)) {
+      absorbs = absorbsAdjoint(sc->op());
+    }
+    else if (InverseSb* inv = dynamic_cast<InverseSb*>(b)) {
+      absorbs = absorbsAdjoint(inv->op());
+    }
+    else if (SumSb* s = dynamic_cast<SumSb*>(b)) {
+      absorbs = absorbsAdjoint(s->lhs()) && absorbsAdjoint(s->rhs());
+    }
+    else if (ProductSb* p = dynamic_cast<ProductSb*>(b)) {
+      absorbs = absorbsAdjoint(p->lhs()) && absorbsAdjoint(p->rhs());
+    }
+
+    m_absorbs_adjoint[b] = std::make_pair(builder, absorbs);
+    return absorbs;
+  }
+
+  double product_cost(const FoProperties& lhs, const FoProperties& rhs)
+  {
+    ArrayFi lcc = lhs.input().lcc(rhs.output());
+    FoProperties product = lhs * rhs;
+
+    // the number of sampling points of the finest grid per diagonal block
+    SplitFrequencyDomain output = product.output();
+    double period =
+      (output.grid().spacing() * output.clusterShape()).cast<double>().prod();
+
+    double rows = output.clusterShape().prod();
+    double inner = lcc.prod();
+    double cols = product.input().clusterShape().prod();
+
+    // the multiplication and the expansion of the operands
+    double cost = rows * inner * cols;
+    if ((lhs.input().clusterShape() != lcc).any())
+      cost += rows * inner;
+    if ((rhs.output().clusterShape() != lcc).any())
+      cost += inner * cols;
+
+    return cost / period;
+  }
+
+  SymbolBuilderPtr simplify(SymbolBuilderPtr builder)
+  {
+    Simplifier simplifier;
+    return simplifier.simplify(builder);
+  }
+
+}
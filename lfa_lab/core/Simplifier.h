@@ -0,0 +1,99 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#ifndef LFA_SIMPLIFIER_H
+#define LFA_SIMPLIFIER_H
+
+#include "Common.h"
+#include "SymbolBuilder.h"
+
+#include <map>
+
+namespace lfa {
+
+  class ProductSb;
+
+  /** Rewrites a graph of symbol builders into an equivalent graph that is
+   * cheaper to evaluate.
+   *
+   * The rewrite removes products with the identity, sums with zero,
+   * trivial powers, and double inverses and adjoints. Scalars are pulled
+   * out of products and powers and folded, operators that are multiples
+   * of the identity are turned into scalars, and adjoints are pushed down
+   * to the stencils. Sums and multiples of stencils on the same grid are
+   * merged into a single stencil. Chains of products are reassociated,
+   * such that the estimated cost of the multiplications (see product_cost)
+   * is minimal, and products with an inverse are turned into solves (see
+   * SolveSb). Builders that are shared in the original graph are also
+   * shared in the result. The dependencies of builders that are not part
+   * of the expression algebra (see ExpressionSb.h) are not rewritten.
+   */
+  class Simplifier {
+    public:
+      SymbolBuilderPtr simplify(SymbolBuilderPtr root);
+
+    private:
+      /** Count how often every builder is used by another builder. */
+      void countUses(SymbolBuilderPtr builder);
+
+      SymbolBuilderPtr rewrite(SymbolBuilderPtr builder);
+
+      /** The rewritten factors of a product. Products that are only used
+       * by this product are flattened. */
+      void collectFactors(ProductSb& product,
+                          vector<SymbolBuilderPtr>& factors);
+
+      /** The product of the factors, evaluated in the cheapest order. */
+      SymbolBuilderPtr chain(const vector<SymbolBuilderPtr>& factors);
+
+      SymbolBuilderPtr sum(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs);
+      SymbolBuilderPtr product(SymbolBuilderPtr lhs, SymbolBuilderPtr rhs);
+      SymbolBuilderPtr scaled(complex<double> scalar, SymbolBuilderPtr op);
+      /** The parameter (a ParameterSb) applied to the rewritten
+       * operator. */
+      SymbolBuilderPtr parameter(SymbolBuilderPtr builder,
+                                 SymbolBuilderPtr op);
+      SymbolBuilderPtr power(SymbolBuilderPtr op, int exponent);
+      SymbolBuilderPtr inverse(SymbolBuilderPtr op);
+      SymbolBuilderPtr adjoint(SymbolBuilderPtr op);
+      SymbolBuilderPtr pushAdjoint(SymbolBuilderPtr op);
+
+      /** Can the adjoint of the builder be formed without an AdjointSb? */
+      bool absorbsAdjoint(SymbolBuilderPtr builder);
+
+      std::map<SymbolBuilder*, int> m_uses;
+      std::map<SymbolBuilder*, SymbolBuilderPtr> m_simplified;
+      /** The keys are stored as well, such that their addresses stay
+       * valid. */
+      std::map<SymbolBuilder*, pair<SymbolBuilderPtr, SymbolBuilderPtr> >
+        m_adjoints;
+      std::map<SymbolBuilder*, pair<SymbolBuilderPtr, bool> >
+        m_absorbs_adjoint;
+  };
+
+  /** The estimated cost of multiplying the symbols of two operators,
+   * including the expansion of their clusters. The cost is given relative
+   * to the number of sampling points on the finest grid. */
+  double product_cost(const FoProperties& lhs, const FoProperties& rhs);
+
+  /** Simplify the graph of builders. See Simplifier. */
+  SymbolBuilderPtr simplify(SymbolBuilderPtr builder);
+
+}
+
+#endif
@@ -50,6 +50,44 @@ void SparseStencil::append(ArrayFi offset, complex<double> value)
     m_elements.push_back(StencilElement(offset, value));
 }
 
+bool SparseStencil::isRealSymmetric(double tolerance) const
+{
+    // sum the values of repeated offsets
+    vector<StencilElement> sums;
+    double magnitude = 0;
+    for (size_t k = 0; k < m_elements.size(); ++k) {
+        const StencilElement& e = m_elements[k];
+        magnitude = std::max(magnitude, abs(e.value));
+
+        size_t i = 0;
+        while (i < sums.size() && !(sums[i].offset == e.offset).all())
+            ++i;
+        if (i == sums.size())
+            sums.push_back(e);
+        else
+            sums[i].value += e.value;
+    }
+
+    double threshold = tolerance * magnitude;
+    for (size_t k = 0; k < sums.size(); ++k) {
+        if (std::abs(imag(sums[k].value)) > threshold)
+            return false;
+
+        // the value at the mirrored offset, zero if it is missing
+        complex<double> mirrored = 0;
+        for (size_t i = 0; i < sums.size(); ++i) {
+            if ((sums[i].offset == -sums[k].offset).all()) {
+                mirrored = sums[i].value;
+                break;
+            }
+        }
+        if (abs(sums[k].value - mirrored) > threshold)
+            return false;
+    }
+
+    return true;
+}
+
 
 
 }
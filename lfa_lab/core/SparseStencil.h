@@ -45,6 +45,11 @@ class SparseStencil {
         int dimension() const;
 
         void append(ArrayFi offset, complex<double> value);
+
+        /** Is the stencil real and symmetric, i.e., are the (summed) values
+         * at the offsets o and -o real and equal up to the relative
+         * tolerance? Then, the symbol of the stencil is real. */
+        bool isRealSymmetric(double tolerance = 1e-12) const;
     private:
         vector<StencilElement> m_elements;
 };
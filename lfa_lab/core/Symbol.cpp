@@ -24,6 +24,8 @@
 #include "SplitFrequencyDomain.h"
 #include "DiscreteDomain.h"
 
+#include <algorithm>
+
 namespace lfa {
 
     Symbol::Symbol(HarmonicClusters output_clusters, HarmonicClusters input_clusters)
@@ -45,14 +47,29 @@ namespace lfa {
                             HarmonicClusters input_clusters)
     {
         Symbol result(output_clusters, input_clusters);
-        for (Symbol::iterator p = result.begin(); p != result.end(); ++p)
-        {
-            if ( (p.row() == p.col()).all() ) {
-                *p = 1;
-            } else {
-                *p = 0;
-            }
+
+        // positions (i, j) of the entries with equal row and column index
+        NdRange rows = output_clusters.clusterIndices();
+        NdRange cols = input_clusters.clusterIndices();
+        int block_rows = result.m_store.block_rows();
+        vector<int> diagonal;
+        for (int i = 0; i < int(rows.size()); ++i) {
+            ArrayFi c = rows.coordOf(i);
+            if (cols.inRange(c))
+                diagonal.push_back(i + block_rows * cols.indexOf(c));
+        }
+
+        for (int b = 0; b < result.m_store.no_blocks(); ++b) {
+            complex<double>* block = result.m_store.block_data(b);
+            for (size_t k = 0; k < diagonal.size(); ++k)
+                block[diagonal[k]] = 1;
         }
+
+        if (output_clusters == input_clusters)
+            result.m_store.setStructure(BdMatrix::Identity);
+        else
+            result.m_store.setStructure(BdMatrix::Dense);
+        result.m_store.setReal(true);
         return result;
     }
 
@@ -93,8 +110,16 @@ namespace lfa {
         HarmonicClusters common_input =
             m_input_clusters.minContainer(other.m_input_clusters);
 
-        Symbol first = this->expand(m_input_clusters.expansionFactor(common_input));
-        Symbol second = other.expand(other.m_input_clusters.expansionFactor(common_input));
+        ArrayFi first_factor = m_input_clusters.expansionFactor(common_input);
+        ArrayFi second_factor =
+            other.m_input_clusters.expansionFactor(common_input);
+
+        // avoid copying operands that do not need to be expanded
+        if (first_factor.isConstant(1) && second_factor.isConstant(1))
+            return addCompatible(other);
+
+        Symbol first = this->expand(first_factor);
+        Symbol second = other.expand(second_factor);
 
         return first.addCompatible(second);
     }
@@ -115,8 +140,14 @@ namespace lfa {
         HarmonicClusters common =
             m_input_clusters.minContainer(other.m_output_clusters);
 
-        Symbol first = this->expand(m_input_clusters.expansionFactor(common));
-        Symbol second = other.expand(other.m_output_clusters.expansionFactor(common));
+        ArrayFi first_factor = m_input_clusters.expansionFactor(common);
+        ArrayFi second_factor = other.m_output_clusters.expansionFactor(common);
+
+        if (first_factor.isConstant(1) && second_factor.isConstant(1))
+            return mulCompatible(other);
+
+        Symbol first = this->expand(first_factor);
+        Symbol second = other.expand(second_factor);
 
         return first.mulCompatible(second);
     }
@@ -144,41 +175,76 @@ namespace lfa {
         Symbol result(m_output_clusters.mergeCluster(factor),
                       m_input_clusters.mergeCluster(factor));
         result.m_store.setZero();
+        if (m_store.structure() == BdMatrix::Zero)
+            return result;
+
+        // Only the diagonals have to be moved, if the rows and the columns
+        // are mapped in the same way.
+        bool diagonal = m_store.isDiagonal()
+            && (m_output_clusters.clusterShape()
+                == m_input_clusters.clusterShape()).all();
+
+        // The base index b of this symbol corresponds to the base index
+        // b' = b mod B' of the result, where B' is the new base shape,
+        // and the sub-base r = b / B'. The cluster index c becomes
+        // c * factor + r. Hence, the positions within a block only depend
+        // on r and are computed once.
+        NdRange sub_bases(factor);
+        NdRange row_clusters = m_output_clusters.clusterIndices();
+        NdRange col_clusters = m_input_clusters.clusterIndices();
+        NdRange result_row_clusters = result.m_output_clusters.clusterIndices();
+        NdRange result_col_clusters = result.m_input_clusters.clusterIndices();
+
+        int no_sub_bases = sub_bases.size();
+        int rows = row_clusters.size();
+        int cols = col_clusters.size();
+        vector<int> row_map(no_sub_bases * rows);
+        vector<int> col_map(no_sub_bases * cols);
+        for (int k = 0; k < no_sub_bases; ++k) {
+            ArrayFi r = sub_bases.coordOf(k);
+            for (int i = 0; i < rows; ++i) {
+                row_map[k * rows + i] = result_row_clusters.indexOf(
+                        row_clusters.coordOf(i) * factor + r);
+            }
+            for (int j = 0; j < cols; ++j) {
+                col_map[k * cols + j] = result_col_clusters.indexOf(
+                        col_clusters.coordOf(j) * factor + r);
+            }
+        }
 
-        // run through the small blocks an distribute the entries
-        NdRange base_idx = m_input_clusters.baseIndices();
-        NdRange row_cluster_idx = m_output_clusters.clusterIndices();
-        NdRange col_cluster_idx = m_input_clusters.clusterIndices();
+        NdRange base_idx = baseIndices();
+        NdRange result_base_idx = result.baseIndices();
+        ArrayFi result_base_shape = result_base_idx.shape();
+
+        for (int bp = 0; bp < int(result_base_idx.size()); ++bp) {
+            ArrayFi result_base = result_base_idx.coordOf(bp);
+            BdMatrix::BlockRef target = result.m_store.block(bp);
+
+            for (int k = 0; k < no_sub_bases; ++k) {
+                int b = base_idx.indexOf(result_base
+                        + result_base_shape * sub_bases.coordOf(k));
+                BdMatrix::ConstBlockRef source = m_store.block(b);
+
+                const int* rm = &row_map[k * rows];
+                const int* cm = &col_map[k * cols];
+                if (diagonal) {
+                    for (int i = 0; i < rows; ++i) {
+                        target(rm[i], rm[i]) = source(i, i);
+                    }
+                    continue;
+                }
 
-        // for each diagonal block
-        for (NdRange::iterator b = base_idx.begin();
-             b != base_idx.end(); ++b)
-        {
-            // for all rows
-            for (NdRange::iterator rc = row_cluster_idx.begin();
-                 rc != row_cluster_idx.end(); ++rc)
-            {
-                // for all columns
-                for (NdRange::iterator cc = col_cluster_idx.begin();
-                     cc != col_cluster_idx.end(); ++cc)
-                {
-                    // convert to target coordinates
-                    ArrayFi target_rb, target_rc;
-                    m_output_clusters.convert(target_rb, target_rc,
-                                              result.m_output_clusters, *b, *rc);
-
-                    ArrayFi target_cb, target_cc;
-                    m_input_clusters.convert(target_cb, target_cc,
-                                             result.m_input_clusters, *b, *cc);
-
-                    assert((target_rb == target_cb).all());
-
-                    // copy value
-                    result.ref(target_rb, target_rc, target_cc) = ref(*b, *rc, *cc);
+                for (int j = 0; j < cols; ++j) {
+                    for (int i = 0; i < rows; ++i) {
+                        target(rm[i], cm[j]) = source(i, j);
+                    }
                 }
             }
         }
 
+        result.m_store.setStructure(diagonal ? m_store.structure()
+                                             : BdMatrix::Dense);
+        result.m_store.setReal(m_store.isReal());
         return result;
     }
 
@@ -190,6 +256,59 @@ namespace lfa {
         return result;
     }
 
+    Symbol Symbol::solve(const Symbol& rhs) const
+    {
+        assert(m_output_clusters == m_input_clusters);
+
+        // the inverse maps to the input clusters of this symbol
+        HarmonicClusters common =
+            m_output_clusters.minContainer(rhs.m_output_clusters);
+
+        ArrayFi first_factor = m_output_clusters.expansionFactor(common);
+        ArrayFi second_factor = rhs.m_output_clusters.expansionFactor(common);
+
+        if (first_factor.isConstant(1) && second_factor.isConstant(1))
+            return solveCompatible(rhs);
+
+        Symbol first = this->expand(first_factor);
+        Symbol second = rhs.expand(second_factor);
+
+        return first.solveCompatible(second);
+    }
+
+    Symbol Symbol::solveCompatible(const Symbol& rhs) const
+    {
+        if ( m_output_clusters != rhs.m_output_clusters )
+            throw logic_error("Symbols not compatible");
+
+        Symbol result(m_input_clusters, rhs.m_input_clusters);
+        result.m_store = m_store.solve(rhs.m_store);
+
+        return result;
+    }
+
+    Symbol Symbol::power(int p) const
+    {
+        if (m_output_clusters != m_input_clusters)
+            throw logic_error("Only symbols of square operators have powers.");
+
+        Symbol result(m_output_clusters, m_input_clusters);
+        result.m_store = m_store.power(p);
+        return result;
+    }
+
+    Symbol Symbol::polynomial(const vector<complex<double> >& coefficients)
+        const
+    {
+        if (m_output_clusters != m_input_clusters)
+            throw logic_error("Only symbols of square operators have "
+                              "polynomials.");
+
+        Symbol result(m_output_clusters, m_input_clusters);
+        result.m_store = m_store.polynomial(coefficients);
+        return result;
+    }
+
     Symbol Symbol::adjoint() const
     {
         Symbol result(m_input_clusters, m_output_clusters);
@@ -199,13 +318,24 @@ namespace lfa {
 
     complex<double>& Symbol::ref(ArrayFi base, ArrayFi cluster_row, ArrayFi cluster_col)
     {
-        // the input and output harmonics have to have the same base indices
-        if (!m_input_clusters.isCompatibleTo(m_output_clusters))
-            throw logic_error("Input and output modes are incompatibel.");
+        // the compatibility of the clusters is ensured by the constructor
+        int b = m_output_clusters.baseIndices().indexOf(base);
+        int i = m_output_clusters.clusterIndices().indexOf(cluster_row);
+        int j = m_input_clusters.clusterIndices().indexOf(cluster_col);
+
+        m_store.forgetStructure();
+        return m_store(b, i, j);
+    }
 
-        SymbolClusterRef cluster_ref(*this, base);
+    complex<double> Symbol::ref(ArrayFi base,
+                                ArrayFi cluster_row,
+                                ArrayFi cluster_col) const
+    {
+        int b = m_output_clusters.baseIndices().indexOf(base);
+        int i = m_output_clusters.clusterIndices().indexOf(cluster_row);
+        int j = m_input_clusters.clusterIndices().indexOf(cluster_col);
 
-        return cluster_ref(cluster_row, cluster_col);
+        return m_store(b, i, j);
     }
 
     void Symbol::setCluster(ArrayFi base, const ClusterSymbol& sym)
@@ -215,6 +345,7 @@ namespace lfa {
 
         int b = baseIndices().indexOf(base);
         m_store.set_block(b, sym.toMatrix());
+        m_store.forgetStructure();
     }
 
     ClusterSymbol Symbol::getCluster(ArrayFi base) const
@@ -238,59 +369,54 @@ namespace lfa {
 
     NdArray<double> Symbol::row_norms() const
     {
-        NdRange output_grid = outputClusters().globalIndices();
-
-        NdArray<double> result_sq(output_grid.shape());
-        for (NdRange::iterator i = output_grid.begin();
-             i != output_grid.end(); ++i)
-        {
-            result_sq(*i) = 0;
-        }
-
-        for (iterator p = const_cast<Symbol*>(this)->begin();
-             p != const_cast<Symbol*>(this)->end(); ++p)
-        {
-            ArrayFi i = outputClusters().globalIndex(p.base(), p.row());
-            //ArrayFi j = inputClusters().globalIndex(p.base(), p.col());
-
-            result_sq(i) += abs_sq(*p);
-        }
-
-        NdArray<double> result(output_grid.shape());
-        for (NdRange::iterator i = output_grid.begin();
-             i != output_grid.end(); ++i)
-        {
-            result(*i) = sqrt(result_sq(*i));
-        }
-
+        NdArray<double> result(m_output_clusters.shape());
+        row_col_norms(result.data(), nullptr);
         return result;
     }
 
-    NdArray<double> Symbol::col_norms() const {
-        NdRange input_grid = inputClusters().globalIndices();
-
-        NdArray<double> result_sq(input_grid.shape());
-        for (NdRange::iterator j = input_grid.begin();
-             j != input_grid.end(); ++j)
-        {
-            result_sq(*j) = 0;
-        }
+    NdArray<double> Symbol::col_norms() const
+    {
+        NdArray<double> result(m_input_clusters.shape());
+        row_col_norms(nullptr, result.data());
+        return result;
+    }
 
-        for (iterator p = const_cast<Symbol*>(this)->begin();
-             p != const_cast<Symbol*>(this)->end(); ++p)
+    void Symbol::row_col_norms(double* row_norms, double* col_norms) const
+    {
+        HarmonicIndexTable rows = m_output_clusters.indexTable();
+        HarmonicIndexTable cols = m_input_clusters.indexTable();
+        int block_rows = m_store.block_rows();
+        int block_cols = m_store.block_cols();
+        int no_blocks = m_store.no_blocks();
+
+        // every block writes to its own rows and columns
+        #pragma omp parallel
         {
-            ArrayFi j = inputClusters().globalIndex(p.base(), p.col());
-            result_sq(j) += abs_sq(*p);
-        }
+            vector<double> row_sq(block_rows);
+
+            #pragma omp for
+            for (int b = 0; b < no_blocks; ++b) {
+                const complex<double>* block = blockData(b);
+                std::fill(row_sq.begin(), row_sq.end(), 0.0);
+
+                for (int j = 0; j < block_cols; ++j) {
+                    const complex<double>* col = block + block_rows * j;
+                    double col_sq = 0;
+                    for (int i = 0; i < block_rows; ++i) {
+                        double a = abs_sq(col[i]);
+                        row_sq[i] += a;
+                        col_sq += a;
+                    }
+                    if (col_norms)
+                        col_norms[cols.global(b, j)] = sqrt(col_sq);
+                }
 
-        NdArray<double> result(input_grid.shape());
-        for (NdRange::iterator j = input_grid.begin();
-             j != input_grid.end(); ++j)
-        {
-            result(*j) = sqrt(result_sq(*j));
+                if (row_norms) {
+                    for (int i = 0; i < block_rows; ++i)
+                        row_norms[rows.global(b, i)] = sqrt(row_sq[i]);
+                }
+            }
         }
-
-        return result;
     }
 
     MatrixXcd Symbol::row_norms_2d() const
@@ -337,11 +463,9 @@ namespace lfa {
         : m_symbol(symbol),
           m_base(base)
     {
-        // the input and output harmonics have to have the same base indices
-        if (!symbol.m_input_clusters.isCompatibleTo(symbol.m_output_clusters))
-            throw logic_error("Input and output modes are incompatibel.");
-
         m_diag_index = symbol.m_output_clusters.baseIndices().indexOf(base);
+        // the entries are written through this reference
+        symbol.m_store.forgetStructure();
     }
 
     complex<double>& SymbolClusterRef::operator() (ArrayFi cluster_row, ArrayFi cluster_col)
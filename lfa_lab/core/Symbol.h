@@ -26,7 +26,7 @@
 #include "HarmonicClusters.h"
 #include "ClusterSymbol.h"
 
-#include "CartIterator.h"
+#include "FixedDimension.h"
 #include "Grid.h"
 #include "SamplingProperties.h"
 #include "NdArray.h"
@@ -48,7 +48,23 @@ class Symbol {
                            HarmonicClusters col_clusters);
         static Symbol Zero(Grid, SamplingProperties conf);
 
+        /** The storage. Its non-const accessors drop the structure tag
+         * and the real flag, see BdMatrix. */
         BdMatrix& matrix() { return m_store; }
+        const BdMatrix& matrix() const { return m_store; }
+        /** The structure of the blocks, see BdMatrix::structure(). */
+        BdMatrix::Structure structure() const {
+            return m_store.structure();
+        }
+        /** Are all entries real, see BdMatrix::isReal()? */
+        bool isReal() const { return m_store.isReal(); }
+
+        /** The column-major block of the b-th (linear) base index. The
+         * non-const overload drops the structure tag and the real flag. */
+        complex<double>* blockData(int b) { return m_store.block_data(b); }
+        const complex<double>* blockData(int b) const {
+            return m_store.block_data(b);
+        }
 
         Symbol addCompatible(const Symbol& other) const;
         Symbol operator+ (const Symbol& other) const;
@@ -66,16 +82,25 @@ class Symbol {
         Symbol inverse() const;
         Symbol adjoint() const;
 
+        /** The product inverse() * rhs, computed without forming the
+         * inverse. */
+        Symbol solve(const Symbol& rhs) const;
+        Symbol solveCompatible(const Symbol& rhs) const;
+
+        /** The p-th power, computed by repeated squaring of the blocks. */
+        Symbol power(int p) const;
+        /** The polynomial sum_k coefficients[k] * S^k of the symbol S,
+         * evaluated blockwise by the Horner scheme. */
+        Symbol polynomial(const vector<complex<double> >& coefficients) const;
+
+        /** The entry for writing. The structure tag and the real flag
+         * are dropped. Readers use the const overload. */
         complex<double>& ref(ArrayFi base,
                              ArrayFi cluster_row,
                              ArrayFi cluster_col);
         complex<double> ref(ArrayFi base,
                             ArrayFi cluster_row,
-                            ArrayFi cluster_col) const {
-            return const_cast<Symbol*>(this)->ref(base,
-                                                  cluster_row,
-                                                  cluster_col);
-        }
+                            ArrayFi cluster_col) const;
 
         NdRange baseIndices() const { return m_output_clusters.baseIndices(); }
 
@@ -98,6 +123,13 @@ class Symbol {
         NdArray<double> row_norms() const;
         NdArray<double> col_norms() const;
 
+        /** Compute the norms of the rows and of the columns in a single
+         * pass over the storage. The norms are written to the buffers,
+         * ordered by the linear global index (see
+         * HarmonicClusters::globalIndices()). Either buffer may be
+         * nullptr. */
+        void row_col_norms(double* row_norms, double* col_norms) const;
+
         VectorXcd row_norms_1d() const;
         VectorXcd col_norms_1d() const;
         MatrixXcd row_norms_2d() const;
@@ -109,9 +141,16 @@ class Symbol {
 
         int dimension() const { return m_output_clusters.dimension(); }
 
-        class iterator;
+        template <typename Value> class basic_iterator;
+        typedef basic_iterator<complex<double> > iterator;
+        typedef basic_iterator<const complex<double> > const_iterator;
+
+        /** Iterate over the entries. The non-const overloads are for
+         * writing and drop the structure tag and the real flag. */
         iterator begin();
         iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
     private:
         /** The number (shape) of the rows and the number (shape) of sampling
          * points. */
@@ -139,67 +178,100 @@ class SymbolClusterRef {
         int m_diag_index;
 };
 
-class Symbol::iterator : public std::iterator<std::input_iterator_tag,
-                                              complex<double> >
+/** Iterates over all entries of a symbol in the order of the storage.
+ *
+ * The rows run fastest, then the columns, then the base indices. The
+ * multi-indices base(), row() and col() are advanced incrementally, like
+ * an odometer, and the corresponding linear indices are available as
+ * baseIndex(), rowIndex() and colIndex(). The entries are of the type
+ * Value, which is const for the const_iterator.
+ */
+template <typename Value>
+class Symbol::basic_iterator
 {
     public:
-        typedef CartIterator<NdRange::iterator, NdRange::iterator> InnerIterator;
-        typedef CartIterator<InnerIterator, NdRange::iterator> OuterIterator;
-
-
-        iterator(Symbol* sym, bool out_of_range = false)
+        typedef std::forward_iterator_tag iterator_category;
+        typedef complex<double> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef Value* pointer;
+        typedef Value& reference;
+
+        basic_iterator(const Symbol* sym, Value* data,
+                       bool out_of_range = false)
+          : m_data(data),
+            m_base_shape(sym->baseIndices().shape()),
+            m_row_shape(sym->outputClusters().clusterShape()),
+            m_col_shape(sym->inputClusters().clusterShape()),
+            m_base(ArrayFi::Zero(sym->dimension())),
+            m_row(ArrayFi::Zero(sym->dimension())),
+            m_col(ArrayFi::Zero(sym->dimension())),
+            m_b(0), m_i(0), m_j(0)
         {
-            m_sym = sym;
-
-            NdRange c_grid = m_sym->inputClusters().clusterIndices();
-            NdRange r_grid = m_sym->outputClusters().clusterIndices();
-
-            InnerIterator inner_begin(c_grid.begin(), c_grid.end(),
-                                      r_grid.begin(), r_grid.end());
-            InnerIterator inner_end(  c_grid.begin(), c_grid.end(),
-                                      r_grid.begin(), r_grid.end(), true);
+            const BdMatrix& store = sym->m_store;
+            m_pos = out_of_range ? store.no_blocks() * store.block_size() : 0;
+            if (out_of_range)
+                m_b = store.no_blocks();
+        }
 
+        bool operator== (const basic_iterator& other) const {
+            return m_data == other.m_data && m_pos == other.m_pos;
+        }
+        bool operator!= (const basic_iterator& other) const {
+            return !(*this == other);
+        }
 
-            NdRange b_grid = m_sym->inputClusters().baseIndices();
-            m_iter = OuterIterator(inner_begin, inner_end,
-                                   b_grid.begin(), b_grid.end(), out_of_range);
+        basic_iterator& operator++ () {
+            ++m_pos;
 
-        }
+            ++m_i;
+            if (next_index<Dynamic>(m_row, m_row_shape))
+                return *this;
 
-        bool operator!= (const iterator& other) {
-            return m_iter != other.m_iter;
-        }
+            m_i = 0;
+            ++m_j;
+            if (next_index<Dynamic>(m_col, m_col_shape))
+                return *this;
 
-        iterator& operator++ () {
-            ++m_iter;
+            m_j = 0;
+            ++m_b;
+            next_index<Dynamic>(m_base, m_base_shape);
 
             return *this;
         }
 
-        ArrayFi base() {
-            return *(m_iter->second);
-        }
-
-        ArrayFi row() {
-            return *(m_iter->first->second);
-        }
+        const ArrayFi& base() const { return m_base; }
+        const ArrayFi& row() const { return m_row; }
+        const ArrayFi& col() const { return m_col; }
 
-        ArrayFi col() {
-            return *(m_iter->first->first);
-        }
+        int baseIndex() const { return m_b; }
+        int rowIndex() const { return m_i; }
+        int colIndex() const { return m_j; }
 
-        complex<double>& operator* () {
-            return m_sym->ref( base(), row(), col() );
+        Value& operator* () const {
+            return m_data[m_pos];
         }
 
     private:
-        OuterIterator m_iter;
+        Value* m_data;
+        int m_pos;
 
-        Symbol* m_sym;
+        ArrayFi m_base_shape, m_row_shape, m_col_shape;
+        ArrayFi m_base, m_row, m_col;
+        int m_b, m_i, m_j;
 };
 
-inline Symbol::iterator Symbol::begin() { return Symbol::iterator(this); }
-inline Symbol::iterator Symbol::end() { return Symbol::iterator(this, true); }
+inline Symbol::iterator Symbol::begin() {
+    return iterator(this, m_store.data());
+}
+inline Symbol::iterator Symbol::end() {
+    return iterator(this, m_store.data(), true);
+}
+inline Symbol::const_iterator Symbol::begin() const {
+    return const_iterator(this, m_store.data());
+}
+inline Symbol::const_iterator Symbol::end() const {
+    return const_iterator(this, m_store.data(), true);
+}
 
 
 }
@@ -25,6 +25,10 @@
 %feature("autodoc",
 "The norms of the columns of the symbol as :math:`n`-D array.") Symbol::col_norms;
 %feature("autodoc",
+"Write the norms of the rows and the columns into two Fortran-ordered
+NumPy arrays of doubles, in a single pass. Either may be None.")
+Symbol::row_col_norms_into;
+%feature("autodoc",
 "The norms of the rows of a 1D symbol as a vector.") Symbol::row_norms_1d;
 %feature("autodoc",
 "The norms of the columns of a 1D symbol as a vector.") Symbol::col_norms_1d;
@@ -37,6 +41,10 @@
 %feature("autodoc", "The eigenvalues of the symbol as a vector.") Symbol::eigenvalues;
 %feature("autodoc", "The dimension of the symbol.") Symbol::dimension;
 %feature("autodoc", "The matrix representation of the symbol.") Symbol::matrix;
+%feature("flatnested") Symbol::const_iterator;
+%rename(SymbolIterator) Symbol::const_iterator;
+// only used by blocks(), which passes the symbol itself as the owner
+%rename(_blocks_view) Symbol::blocks_view;
 class Symbol {
     public:
         static Symbol Identity(Grid grid, SamplingProperties conf);
@@ -50,7 +58,7 @@ class Symbol {
         MatrixXcd row_norms_2d() const;
         MatrixXcd col_norms_2d() const;
 
-        BdMatrix matrix();
+        BdMatrix matrix() const;
 
         Symbol expand(ArrayFi factor) const;
 
@@ -72,8 +80,84 @@ class Symbol {
 
         const HarmonicClusters& outputClusters() const;
         const HarmonicClusters& inputClusters() const;
+
+        class const_iterator {
+            public:
+                bool operator== (const const_iterator& other) const;
+                bool operator!= (const const_iterator& other) const;
+
+                ArrayFi base() const;
+                ArrayFi row() const;
+                ArrayFi col() const;
+        };
+
+        const_iterator begin() const;
+        const_iterator end() const;
 };
 
+%extend Symbol::const_iterator {
+    void advance() {
+        ++(*$self);
+    }
+    std::complex<double> value() {
+        return **$self;
+    }
+}
+
+%pythoncode %{
+
+def Symbol__iter__(self):
+  """Iterate over the entries of the symbol as tuples (base, row, col,
+  value), in the order of the storage."""
+  iter = self.begin()
+  end = self.end()
+  while iter != end:
+    yield (iter.base(), iter.row(), iter.col(), iter.value())
+    iter.advance()
+
+setattr(Symbol, r'__iter__', Symbol__iter__)
+
+def Symbol_norms(self):
+  """The norms of the rows and of the columns as a pair of NumPy arrays
+  of the output and the input shape, computed in a single pass."""
+  import numpy as np
+  rows = np.empty(tuple(self.output_shape()), order='F')
+  cols = np.empty(tuple(self.input_shape()), order='F')
+  self.row_col_norms_into(rows, cols)
+  return (rows, cols)
+
+def Symbol_row_norms_array(self):
+  """The norms of the rows as a NumPy array of the output shape."""
+  import numpy as np
+  rows = np.empty(tuple(self.output_shape()), order='F')
+  self.row_col_norms_into(rows, None)
+  return rows
+
+def Symbol_col_norms_array(self):
+  """The norms of the columns as a NumPy array of the input shape."""
+  import numpy as np
+  cols = np.empty(tuple(self.input_shape()), order='F')
+  self.row_col_norms_into(None, cols)
+  return cols
+
+def Symbol_blocks(self):
+  """The block storage as a read-only complex NumPy array of the shape
+  (blocks, rows, cols), without copying. The array shares the memory
+  with the symbol and keeps the symbol alive. Unlike matrix().full(), it
+  does not assemble the dense block diagonal matrix.
+
+  The array refers to the current storage of the symbol. Once the symbol
+  is modified in place, e.g., by an assignment, the array must not be
+  used anymore. Copy the array to keep the values."""
+  return self._blocks_view(self)
+
+setattr(Symbol, r'norms', Symbol_norms)
+setattr(Symbol, r'row_norms_array', Symbol_row_norms_array)
+setattr(Symbol, r'col_norms_array', Symbol_col_norms_array)
+setattr(Symbol, r'blocks', Symbol_blocks)
+
+%}
+
 %extend Symbol {
     Symbol __add__(const Symbol& other) {
         return *$self + other;
@@ -120,5 +204,49 @@ class Symbol {
     ArrayFi input_shape() {
         return $self->inputClusters().shape();
     }
+
+    void row_col_norms_into(PyObject* row_norms, PyObject* col_norms) {
+        double* rows = numpyDoubleBuffer(row_norms,
+                                         $self->outputClusters().size());
+        double* cols = numpyDoubleBuffer(col_norms,
+                                         $self->inputClusters().size());
+        $self->row_col_norms(rows, cols);
+    }
+
+    PyObject* blocks_view(PyObject* owner) {
+        // the const storage, such that the structure tag is kept
+        const BdMatrix& store = static_cast<const Symbol*>($self)->matrix();
+
+        // the blocks are stored one after another, each in column-major
+        // order
+        const npy_intp item = sizeof(std::complex<double>);
+        npy_intp dims[3] = { store.no_blocks(),
+                             store.block_rows(),
+                             store.block_cols() };
+        npy_intp strides[3] = { store.block_size() * item,
+                                item,
+                                store.block_rows() * item };
+
+        // the array is not writeable (no NPY_ARRAY_WRITEABLE flag), since
+        // writing through it would bypass the structure tag and the real
+        // flag of the storage
+        std::complex<double>* data =
+            const_cast<std::complex<double>*>(store.data());
+        PyObject* obj = PyArray_New(&PyArray_Type, 3, dims, NPY_COMPLEX128,
+                                    strides, data, 0,
+                                    NPY_ARRAY_ALIGNED, nullptr);
+        if (!obj)
+            throw std::runtime_error("Cannot create the NumPy view.");
+
+        // the array holds a reference to the owner of the storage
+        Py_INCREF(owner);
+        if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(obj),
+                                  owner) < 0) {
+            Py_DECREF(obj);
+            throw std::runtime_error("Cannot create the NumPy view.");
+        }
+
+        return obj;
+    }
 }
 
@@ -18,11 +18,176 @@
 */
 
 #include "SymbolBuilder.h"
+#include "Hash.h"
+
+#include <functional>
+#include <map>
+#include <set>
 
 namespace lfa {
 
 SymbolBuilder::~SymbolBuilder()
 { }
 
+Symbol SymbolBuilder::generateExpanded(const SamplingProperties& conf,
+                                       ArrayFi factor)
+{
+    if (factor.isConstant(1))
+        return generate(conf);
+
+    return generate(conf).expand(factor);
+}
+
+vector<SymbolBuilderPtr> SymbolBuilder::dependencies()
+{
+    return vector<SymbolBuilderPtr>();
+}
+
+Symbol SymbolBuilder::combine(const SamplingProperties& conf,
+                              const vector<Symbol>& symbols)
+{
+    if (!symbols.empty())
+        throw logic_error("The symbol builder has no dependencies.");
+
+    return generate(conf);
+}
+
+bool SymbolBuilder::combinesExpanded()
+{
+    return false;
+}
+
+vector<string> SymbolBuilder::parameters()
+{
+    return vector<string>();
+}
+
+Symbol SymbolBuilder::combineWith(const SamplingProperties& conf,
+                                  const vector<Symbol>& symbols,
+                                  const ParameterValues& values)
+{
+    return combine(conf, symbols);
+}
+
+bool SymbolBuilder::realCoefficients(const SamplingProperties& conf)
+{
+    return false;
+}
+
+size_t SymbolBuilder::hash()
+{
+    return std::hash<SymbolBuilder*>()(this);
+}
+
+bool SymbolBuilder::equals(SymbolBuilder& other)
+{
+    return this == &other;
+}
+
+Symbol SymbolBuilder::generateFromDependencies(const SamplingProperties& conf)
+{
+    vector<SymbolBuilderPtr> deps = dependencies();
+
+    vector<Symbol> symbols;
+    symbols.reserve(deps.size());
+    for (size_t i = 0; i < deps.size(); ++i) {
+        symbols.push_back(deps[i]->generate(conf));
+    }
+
+    return combine(conf, symbols);
+}
+
+namespace {
+
+    // A shared dependency is visited once, hence, the cost of the
+    // following traversals is linear in the size of the DAG.
+
+    size_t structural_hash(SymbolBuilder& builder,
+                           std::map<SymbolBuilder*, size_t>& known)
+    {
+        std::map<SymbolBuilder*, size_t>::iterator k = known.find(&builder);
+        if (k != known.end())
+            return k->second;
+
+        size_t seed = builder.hash();
+
+        vector<SymbolBuilderPtr> deps = builder.dependencies();
+        for (size_t i = 0; i < deps.size(); ++i) {
+            hash_combine(seed, structural_hash(*deps[i], known));
+        }
+
+        known[&builder] = seed;
+        return seed;
+    }
+
+    bool has_real_coefficients(SymbolBuilder& builder,
+                               const SamplingProperties& conf,
+                               std::set<SymbolBuilder*>& real)
+    {
+        if (real.count(&builder))
+            return true;
+
+        if (!builder.realCoefficients(conf))
+            return false;
+
+        vector<SymbolBuilderPtr> deps = builder.dependencies();
+        for (size_t i = 0; i < deps.size(); ++i) {
+            if (!has_real_coefficients(*deps[i], conf, real))
+                return false;
+        }
+
+        real.insert(&builder);
+        return true;
+    }
+
+    typedef std::pair<SymbolBuilder*, SymbolBuilder*> BuilderPair;
+
+    bool structurally_equal(SymbolBuilder& a, SymbolBuilder& b,
+                            std::set<BuilderPair>& equal)
+    {
+        if (&a == &b || equal.count(BuilderPair(&a, &b)))
+            return true;
+
+        if (!a.equals(b))
+            return false;
+
+        vector<SymbolBuilderPtr> a_deps = a.dependencies();
+        vector<SymbolBuilderPtr> b_deps = b.dependencies();
+        if (a_deps.size() != b_deps.size())
+            return false;
+
+        for (size_t i = 0; i < a_deps.size(); ++i) {
+            if (!structurally_equal(*a_deps[i], *b_deps[i], equal))
+                return false;
+        }
+
+        equal.insert(BuilderPair(&a, &b));
+        return true;
+    }
+
+}
+
+size_t structural_hash(SymbolBuilder& builder)
+{
+    std::map<SymbolBuilder*, size_t> known;
+    return structural_hash(builder, known);
+}
+
+bool has_real_coefficients(SymbolBuilder& builder,
+                           const SamplingProperties& conf)
+{
+    // Only the builders with real coefficients are remembered, the
+    // traversal stops at the first other one.
+    std::set<SymbolBuilder*> real;
+    return has_real_coefficients(builder, conf, real);
 }
 
+bool structurally_equal(SymbolBuilder& a, SymbolBuilder& b)
+{
+    // Only the equal pairs are remembered, the traversal stops at the
+    // first unequal one.
+    std::set<BuilderPair> equal;
+    return structurally_equal(a, b, equal);
+}
+
+}
@@ -25,16 +25,89 @@
 #include "FoProperties.h"
 #include "SamplingProperties.h"
 
+#include <map>
+
 namespace lfa {
 
+class SymbolBuilder;
+
+typedef shared_ptr<SymbolBuilder> SymbolBuilderPtr;
+
+/** The values of named parameters, see ParameterSb. */
+typedef std::map<string, complex<double> > ParameterValues;
+
 class SymbolBuilder {
     public:
         virtual ~SymbolBuilder();
 
         virtual FoProperties properties() = 0;
         virtual Symbol generate(const SamplingProperties& conf) = 0;
+
+        /** Generate the symbol with its clusters merged by the given
+         * factor, i.e., generate(conf).expand(factor). Builders that can
+         * sample directly into the merged clusters override this method to
+         * avoid the copy. */
+        virtual Symbol generateExpanded(const SamplingProperties& conf,
+                                        ArrayFi factor);
+
+        /** The builders whose symbols are combined into the symbol of this
+         * builder. A builder without dependencies generates its symbol
+         * directly. */
+        virtual vector<SymbolBuilderPtr> dependencies();
+
+        /** Compute the symbol from the symbols of the dependencies, given in
+         * the order of dependencies(). */
+        virtual Symbol combine(const SamplingProperties& conf,
+                               const vector<Symbol>& symbols);
+
+        /** Can combine() handle symbols of the dependencies whose clusters
+         * are merged further than required by their properties? */
+        virtual bool combinesExpanded();
+
+        /** The names of the parameters the symbol of this builder depends
+         * on, excluding those of the dependencies. See ParameterSb. */
+        virtual vector<string> parameters();
+
+        /** Like combine(), for the given values of the parameters. By
+         * default, the values are ignored. */
+        virtual Symbol combineWith(const SamplingProperties& conf,
+                                   const vector<Symbol>& symbols,
+                                   const ParameterValues& values);
+
+        /** Does the operation have real coefficients, i.e., does its
+         * sampled symbol satisfy A(-theta) = conj(A(theta)) (up to the
+         * order of the harmonics), provided that the dependencies have
+         * real coefficients? By default, this is not assumed. */
+        virtual bool realCoefficients(const SamplingProperties& conf);
+
+        /** A hash of the operation and the parameters of this builder,
+         * excluding its dependencies. Equal builders have equal hashes. */
+        virtual size_t hash();
+
+        /** Does the other builder perform the same operation with the same
+         * parameters? The dependencies are not compared. By default, a
+         * builder is only equal to itself. */
+        virtual bool equals(SymbolBuilder& other);
+
+    protected:
+        /** Generate the symbols of all dependencies and combine them. A
+         * dependency that is used more than once is generated repeatedly.
+         * Use a DagEvaluator to avoid this. */
+        Symbol generateFromDependencies(const SamplingProperties& conf);
 };
 
+/** A hash of the builder and all its dependencies. */
+size_t structural_hash(SymbolBuilder& builder);
+
+/** Do the builder and all its dependencies have real coefficients (see
+ * SymbolBuilder::realCoefficients)? */
+bool has_real_coefficients(SymbolBuilder& builder,
+                           const SamplingProperties& conf);
+
+/** Do both builders and all their dependencies perform the same
+ * operations? If so, they generate the same symbols. */
+bool structurally_equal(SymbolBuilder& a, SymbolBuilder& b);
+
 }
 
 #endif
@@ -0,0 +1,171 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "SymbolCache.h"
+
+namespace lfa {
+
+  SymbolCache::Entry::Entry(size_t hash, SymbolBuilderPtr builder,
+                            const SamplingProperties& conf,
+                            const ArrayFi& factor,
+                            shared_ptr<const Symbol> symbol)
+    : hash(hash),
+      builder(builder),
+      conf(conf),
+      factor(factor),
+      symbol(symbol)
+  {
+    const BdMatrix& m = this->symbol->matrix();
+    bytes = size_t(m.no_blocks()) * m.block_size() * sizeof(complex<double>);
+  }
+
+  SymbolCache::SymbolCache(size_t capacity)
+    : m_memory(0),
+      m_capacity(capacity)
+  { }
+
+  SymbolCache& SymbolCache::global()
+  {
+    static SymbolCache cache;
+    return cache;
+  }
+
+  bool SymbolCache::lookup(size_t hash,
+                           SymbolBuilder& builder,
+                           const SamplingProperties& conf,
+                           const ArrayFi& factor,
+                           Symbol& symbol)
+  {
+    shared_ptr<const Symbol> found;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      typedef std::multimap<size_t, EntryIterator>::iterator IndexIterator;
+      std::pair<IndexIterator, IndexIterator> range
+        = m_index.equal_range(hash);
+
+      for (IndexIterator i = range.first; i != range.second; ++i) {
+        Entry& entry = *i->second;
+        if (entry.conf == conf
+            && entry.factor.rows() == factor.rows()
+            && (entry.factor == factor).all()
+            && structurally_equal(*entry.builder, builder))
+        {
+          found = entry.symbol;
+          // the entry becomes the most recently used one
+          m_entries.splice(m_entries.end(), m_entries, i->second);
+          break;
+        }
+      }
+    }
+
+    if (!found)
+      return false;
+
+    // the copy is made without holding the lock
+    symbol = *found;
+    return true;
+  }
+
+  void SymbolCache::insert(size_t hash,
+                           SymbolBuilderPtr builder,
+                           const SamplingProperties& conf,
+                           const ArrayFi& factor,
+                           const Symbol& symbol)
+  {
+    // the copy is made without holding the lock
+    shared_ptr<const Symbol> stored(new Symbol(symbol));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_capacity > 0) {
+      m_entries.push_back(Entry(hash, builder, conf, factor, stored));
+      EntryIterator entry = --m_entries.end();
+
+      m_index.insert(std::make_pair(hash, entry));
+      m_memory += entry->bytes;
+
+      shrink();
+    }
+  }
+
+  void SymbolCache::shrink()
+  {
+    while (m_memory > m_capacity && !m_entries.empty()) {
+      // the least recently used entry
+      EntryIterator oldest = m_entries.begin();
+
+      typedef std::multimap<size_t, EntryIterator>::iterator IndexIterator;
+      std::pair<IndexIterator, IndexIterator> range
+        = m_index.equal_range(oldest->hash);
+      for (IndexIterator i = range.first; i != range.second; ++i) {
+        if (i->second == oldest) {
+          m_index.erase(i);
+          break;
+        }
+      }
+
+      m_memory -= oldest->bytes;
+      m_entries.erase(oldest);
+    }
+  }
+
+  void SymbolCache::clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+    m_memory = 0;
+  }
+
+  int SymbolCache::size()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+  }
+
+  size_t SymbolCache::memory()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memory;
+  }
+
+  size_t SymbolCache::capacity()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+  }
+
+  void SymbolCache::setCapacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    shrink();
+  }
+
+  void clear_symbol_cache()
+  {
+    SymbolCache::global().clear();
+  }
+
+  void set_symbol_cache_capacity(size_t capacity)
+  {
+    SymbolCache::global().setCapacity(capacity);
+  }
+
+}
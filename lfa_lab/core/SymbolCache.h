@@ -0,0 +1,117 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LFA_SYMBOL_CACHE_H
+#define LFA_SYMBOL_CACHE_H
+
+#include "Common.h"
+#include "SymbolBuilder.h"
+
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace lfa {
+
+  /** Stores symbols that have already been computed.
+   *
+   * A symbol is identified by the structure of the builder that generated
+   * it, by the sampling, and by the factor its clusters have been merged
+   * by (see SymbolBuilder::generateExpanded). Hence, a builder that is
+   * constructed again with the same parameters, e.g., in a parameter
+   * sweep, reuses the symbol. If the capacity is exceeded, the least
+   * recently used symbols are removed. All methods may be called
+   * concurrently, from OpenMP and from other threads.
+   */
+  class SymbolCache {
+    public:
+      /** @param capacity The maximal memory used by the symbols in bytes. */
+      explicit SymbolCache(size_t capacity = 256 << 20);
+
+      /** The cache used by Expression::symbol. */
+      static SymbolCache& global();
+
+      /** Find the symbol generated by the builder.
+       * @param hash The structural_hash of the builder.
+       * @return True, if the symbol was found.
+       */
+      bool lookup(size_t hash,
+                  SymbolBuilder& builder,
+                  const SamplingProperties& conf,
+                  const ArrayFi& factor,
+                  Symbol& symbol);
+
+      /** Store the symbol generated by the builder. */
+      void insert(size_t hash,
+                  SymbolBuilderPtr builder,
+                  const SamplingProperties& conf,
+                  const ArrayFi& factor,
+                  const Symbol& symbol);
+
+      /** Remove all symbols. */
+      void clear();
+
+      /** The number of stored symbols. */
+      int size();
+
+      /** The memory used by the stored symbols in bytes. */
+      size_t memory();
+
+      size_t capacity();
+      void setCapacity(size_t capacity);
+    private:
+      struct Entry {
+        Entry(size_t hash, SymbolBuilderPtr builder,
+              const SamplingProperties& conf, const ArrayFi& factor,
+              shared_ptr<const Symbol> symbol);
+
+        size_t hash;
+        SymbolBuilderPtr builder;
+        SamplingProperties conf;
+        ArrayFi factor;
+        /** Shared, such that a symbol can be copied out of the cache
+         * without holding the lock, even if it is evicted meanwhile. */
+        shared_ptr<const Symbol> symbol;
+        size_t bytes;
+      };
+      typedef std::list<Entry>::iterator EntryIterator;
+
+      /** Remove the least recently used entries until the capacity is
+       * respected. The caller holds the lock. */
+      void shrink();
+
+      /** The entries, least recently used first. */
+      std::list<Entry> m_entries;
+      std::multimap<size_t, EntryIterator> m_index;
+      size_t m_memory;
+      size_t m_capacity;
+      /** Guards all members. */
+      std::mutex m_mutex;
+  };
+
+  /** Remove all symbols from the global symbol cache. */
+  void clear_symbol_cache();
+
+  /** Set the maximal memory used by the global symbol cache in bytes. A
+   * capacity of zero disables the cache. */
+  void set_symbol_cache_capacity(size_t capacity);
+
+}
+
+#endif
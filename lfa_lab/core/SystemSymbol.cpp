@@ -199,13 +199,16 @@ double SystemSymbol::spectral_radius() const
 {
   vector<double> max_evs;
 
+  // all cluster matrices have the same size, so one solver suffices
+  EigenvalueSolver solver;
+
   NdRange bases = baseIndices();
   for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b)
   {
     SystemClusterSymbol aux = at(*b);
 
     max_evs.push_back(
-      abs(eigenvalue_max_magnitude(aux.matrix())));
+      abs(eigenvalue_max_magnitude(aux.matrix(), solver)));
   }
 
   return *max_element(max_evs.begin(), max_evs.end());
@@ -220,9 +223,8 @@ double SystemSymbol::squared_spectral_norm() const
   {
     SystemClusterSymbol aux = at(*b);
 
-    max_evs.push_back(
-      abs(eigenvalue_max_magnitude(aux.matrix().adjoint()
-                                   * aux.matrix())));
+    double sigma = singular_value_max(aux.matrix());
+    max_evs.push_back(sigma * sigma);
   }
 
   return *max_element(max_evs.begin(), max_evs.end());
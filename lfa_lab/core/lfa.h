@@ -21,6 +21,7 @@
 #define LFA_H
 
 #include <lfa_lab/core/Common.h>
+#include <lfa_lab/core/Parallel.h>
 #include <lfa_lab/core/SparseStencil.h>
 #include <lfa_lab/core/StencilGallery.h>
 #include <lfa_lab/core/SystemSymbol.h>
@@ -30,5 +31,8 @@
 #include <lfa_lab/core/ConstantSb.h>
 #include <lfa_lab/core/HpFilterSb.h>
 #include <lfa_lab/core/SystemSymbolProperties.h>
+#include <lfa_lab/core/Expression.h>
+#include <lfa_lab/core/LazySymbol.h>
+#include <lfa_lab/core/SymbolCache.h>
 
 #endif
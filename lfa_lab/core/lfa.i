@@ -71,6 +71,8 @@ using namespace lfa;
 %include "HpFilterSb.i"
 %include "SystemSymbolProperties.i"
 %include "BdMatrix.i"
+%include "Expression.i"
+%include "LazySymbol.i"
 
 // =========================================================
 
@@ -91,3 +93,17 @@ BlockStencil flux_conserving_int_2d(BlockStencil L);
 
 void enable_fpe();
 
+%feature("autodoc", "Set the number of threads used for the block-wise
+computations. For values smaller than one, all available processors are
+used.") set_num_threads;
+void set_num_threads(int n);
+%feature("autodoc", "The number of threads used for the block-wise
+computations.") num_threads;
+int num_threads();
+
+%feature("autodoc", "Remove all symbols from the symbol cache.")
+clear_symbol_cache;
+void clear_symbol_cache();
+%feature("autodoc", "Set the maximal memory used by the symbol cache in
+bytes. A capacity of zero disables the cache.") set_symbol_cache_capacity;
+void set_symbol_cache_capacity(size_t capacity);
@@ -18,8 +18,11 @@
 */
 
 #include <gtest/gtest.h>
+#include <Eigen/SVD>
 
 #include "BdMatrix.h"
+#include "EigenSolver.h"
+#include "ExEigenSolver.h"
 
 using namespace lfa;
 
@@ -92,3 +95,413 @@ TEST(BdMatrix, eigenvalues)
 }
 
 
+TEST(BdMatrix, ContiguousStorage)
+{
+    BdMatrix M(3, 2, 3);
+    for (int b = 0; b < M.no_blocks(); ++b) {
+        for (int j = 0; j < M.block_cols(); ++j) {
+            for (int i = 0; i < M.block_rows(); ++i) {
+                M(b, i, j) = complex<double>(b, 10 * i + j);
+            }
+        }
+    }
+
+    // the blocks are stored one after another in column-major order
+    EXPECT_EQ(6, M.block_size());
+    EXPECT_EQ(M.data() + 6, M.block_data(1));
+    EXPECT_EQ(complex<double>(2, 1), M.data()[2 * 6 + 1 * 2 + 0]);
+
+    // the block views share the storage
+    M.block(1)(1, 2) = 42;
+    EXPECT_EQ(complex<double>(42), M(1, 1, 2));
+
+    BdMatrix S = M + M;
+    BdMatrix T = complex<double>(2) * M;
+    EXPECT_LE((S.full() - T.full()).norm(), 1e-12);
+    EXPECT_LE((S.full() - 2.0 * M.full()).norm(), 1e-12);
+
+    BdMatrix P = M * M.adjoint();
+    EXPECT_EQ(2, P.block_rows());
+    EXPECT_EQ(2, P.block_cols());
+    EXPECT_LE((P.full() - M.full() * M.full().adjoint()).norm(), 1e-10);
+
+    EXPECT_NEAR(M.full().norm(), M.norm(), 1e-10);
+}
+
+TEST(BdMatrix, BlockLoops)
+{
+    const int n = 64;
+    BdMatrix M(n, 2, 2);
+    for (int b = 0; b < n; ++b) {
+        MatrixXcd A(2, 2);
+        A << b + 1, 1,
+             0,     2;
+        M.set_block(b, A);
+    }
+
+    EXPECT_NEAR(n, M.spectral_radius(), 1e-10);
+    EXPECT_TRUE((M.inverse() * M).full().isIdentity(1e-10));
+
+    VectorXcd ews = M.eigenvalues();
+    for (int b = 0; b < n; ++b) {
+        std::sort(ews.data() + 2*b, ews.data() + 2*b + 2, cmplx_lex_less);
+        EXPECT_NEAR(std::min(b + 1, 2), real(ews(2*b)), 1e-10);
+        EXPECT_NEAR(std::max(b + 1, 2), real(ews(2*b + 1)), 1e-10);
+    }
+
+    // the first singular block is reported
+    M.set_block(3, MatrixXcd::Zero(2, 2));
+    M.set_block(7, MatrixXcd::Zero(2, 2));
+    try {
+        M.inverse();
+        FAIL() << "Expected an exception.";
+    } catch (const runtime_error& e) {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("block 3."));
+    }
+}
+
+TEST(BdMatrix, PowerAndPolynomial)
+{
+    BdMatrix M(5, 3, 3);
+    for (int b = 0; b < M.no_blocks(); ++b) {
+        M.set_block(b, MatrixXcd::Random(3, 3) / 2.0);
+    }
+
+    // compare with repeated multiplication
+    BdMatrix P = M;
+    for (int p = 1; p <= 9; ++p) {
+        EXPECT_LE((M.power(p).full() - P.full()).norm(), 1e-12);
+        P = P * M;
+    }
+    EXPECT_TRUE(M.power(0).full().isIdentity(1e-14));
+    EXPECT_THROW(BdMatrix(2, 2, 3).power(2), logic_error);
+
+    // 2 - M + 3 M^3
+    vector<complex<double> > c(4);
+    c[0] = 2.0;
+    c[1] = -1.0;
+    c[3] = 3.0;
+    MatrixXcd F = M.full();
+    MatrixXcd I = MatrixXcd::Identity(F.rows(), F.cols());
+    MatrixXcd expected = 2.0 * I - F + 3.0 * F * F * F;
+    EXPECT_LE((M.polynomial(c).full() - expected).norm(), 1e-12);
+    EXPECT_LE(M.polynomial(vector<complex<double> >()).norm(), 0.0);
+}
+
+TEST(BdMatrix, Solve)
+{
+    BdMatrix M(6, 3, 3);
+    BdMatrix B(6, 3, 2);
+    for (int b = 0; b < M.no_blocks(); ++b) {
+        M.set_block(b, MatrixXcd::Random(3, 3)
+                       + 4.0 * MatrixXcd::Identity(3, 3));
+        B.set_block(b, MatrixXcd::Random(3, 2));
+    }
+
+    BdMatrix X = M.solve(B);
+    EXPECT_EQ(2, X.block_cols());
+    EXPECT_LE((X.full() - (M.inverse() * B).full()).norm(), 1e-12);
+    EXPECT_LE(((M * X).full() - B.full()).norm(), 1e-12);
+
+    // the first singular block is reported, as for the inverse
+    M.set_block(4, MatrixXcd::Zero(3, 3));
+    try {
+        M.solve(B);
+        FAIL() << "Expected an exception.";
+    } catch (const runtime_error& e) {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("block 4."));
+    }
+}
+
+TEST(BdMatrix, Structure)
+{
+    const int n = 4;
+    BdMatrix D(n, 3, 3);
+    D.setZero();
+    for (int b = 0; b < n; ++b) {
+        for (int i = 0; i < 3; ++i) {
+            D(b, i, i) = complex<double>(b + i + 1, i);
+        }
+    }
+    D.setStructure(BdMatrix::Diagonal);
+
+    BdMatrix I(n, 3, 3);
+    I.setZero();
+    for (int b = 0; b < n; ++b) {
+        I.block(b).setIdentity();
+    }
+    I.setStructure(BdMatrix::Identity);
+
+    BdMatrix Z(n, 3, 3);
+    Z.setZero();
+    EXPECT_EQ(BdMatrix::Zero, Z.structure());
+
+    BdMatrix A(n, 3, 2);
+    for (int b = 0; b < n; ++b) {
+        A.set_block(b, MatrixXcd::Random(3, 2));
+    }
+    EXPECT_EQ(BdMatrix::Dense, A.structure());
+    // blocks of size 1x1 are always diagonal
+    EXPECT_EQ(BdMatrix::Diagonal, BdMatrix(n, 1, 1).structure());
+
+    // the same entries without a structure
+    BdMatrix dense_d = D;
+    dense_d.setStructure(BdMatrix::Dense);
+    MatrixXcd d = D.full();
+
+    EXPECT_EQ(BdMatrix::Diagonal, (D + I).structure());
+    EXPECT_LE(((D + I).full() - (dense_d + I).full()).norm(), 1e-12);
+    EXPECT_LE(((Z + D).full() - d).norm(), 0.0);
+
+    EXPECT_EQ(BdMatrix::Diagonal, (D * D).structure());
+    EXPECT_LE(((D * D).full() - d * d).norm(), 1e-12);
+    EXPECT_LE(((D * A).full() - d * A.full()).norm(), 1e-12);
+    EXPECT_LE(((A.adjoint() * D).full() - A.full().adjoint() * d).norm(),
+              1e-12);
+    EXPECT_LE(((I * A).full() - A.full()).norm(), 0.0);
+    EXPECT_EQ(BdMatrix::Zero, (Z * D).structure());
+
+    EXPECT_EQ(BdMatrix::Diagonal, (complex<double>(2) * I).structure());
+    EXPECT_EQ(BdMatrix::Identity, I.adjoint().structure());
+
+    EXPECT_EQ(BdMatrix::Diagonal, D.inverse().structure());
+    EXPECT_LE((D.inverse().full() - dense_d.inverse().full()).norm(), 1e-12);
+    EXPECT_LE((D.solve(A).full() - dense_d.solve(A).full()).norm(), 1e-12);
+    EXPECT_THROW(Z.inverse(), runtime_error);
+
+    EXPECT_LE((D.power(5).full() - dense_d.power(5).full()).norm(), 1e-9);
+    EXPECT_EQ(BdMatrix::Identity, D.power(0).structure());
+    vector<complex<double> > c(3, 1.0);
+    EXPECT_LE((D.polynomial(c).full() - dense_d.polynomial(c).full()).norm(),
+              1e-10);
+
+    EXPECT_NEAR(dense_d.spectral_radius(), D.spectral_radius(), 1e-10);
+    EXPECT_NEAR(dense_d.spectral_norm(), D.spectral_norm(), 1e-10);
+    VectorXcd ews = D.eigenvalues();
+    VectorXcd dense_ews = dense_d.eigenvalues();
+    std::sort(ews.data(), ews.data() + ews.size(), cmplx_lex_less);
+    std::sort(dense_ews.data(), dense_ews.data() + dense_ews.size(),
+              cmplx_lex_less);
+    EXPECT_LE((ews - dense_ews).norm(), 1e-10);
+}
+
+TEST(BdMatrix, WritingDropsStructure)
+{
+    const int n = 3;
+    BdMatrix A(n, 2, 2);
+    for (int b = 0; b < n; ++b) {
+        A.set_block(b, MatrixXcd::Random(2, 2));
+    }
+
+    // every kind of write access, after the matrix has been zeroed
+    BdMatrix W(n, 2, 2);
+    W.setZero();
+    W(0, 0, 1) = 1.0;
+    EXPECT_EQ(BdMatrix::Dense, W.structure());
+    EXPECT_LE(((W + A).full() - (W.full() + A.full())).norm(), 1e-14);
+    EXPECT_LE(((W * A).full() - W.full() * A.full()).norm(), 1e-14);
+
+    W.setZero();
+    W.block(1)(1, 0) = 2.0;
+    EXPECT_EQ(BdMatrix::Dense, W.structure());
+    EXPECT_LE(((A * W).full() - A.full() * W.full()).norm(), 1e-14);
+
+    W.setZero();
+    W.data()[W.block_size()] = 3.0;
+    EXPECT_EQ(BdMatrix::Dense, W.structure());
+    EXPECT_LE(((A + W).full() - (A.full() + W.full())).norm(), 1e-14);
+
+    W.setZero();
+    W.block_data(2)[3] = 4.0;
+    EXPECT_LE(((W * A).full() - W.full() * A.full()).norm(), 1e-14);
+
+    // reading from a const matrix keeps the structure
+    W.setZero();
+    const BdMatrix& Z = W;
+    EXPECT_EQ(0.0, Z(0, 0, 0));
+    EXPECT_EQ(0.0, Z.block(0).norm());
+    EXPECT_EQ(BdMatrix::Zero, W.structure());
+}
+
+TEST(BdMatrix, RealArithmetic)
+{
+    const int n = 5;
+    const int m = 4;
+    BdMatrix A(n, m, m), B(n, m, m);
+    for (int b = 0; b < n; ++b) {
+        A.set_block(b, (MatrixXd::Random(m, m)
+                        + 4 * MatrixXd::Identity(m, m))
+                       .cast<complex<double> >());
+        B.set_block(b, MatrixXd::Random(m, m).cast<complex<double> >());
+    }
+    EXPECT_FALSE(A.isReal());
+
+    // the same entries, computed in complex arithmetic
+    BdMatrix complex_a = A;
+    BdMatrix complex_b = B;
+    A.setReal(true);
+    B.setReal(true);
+
+    EXPECT_TRUE((A * B).isReal());
+    EXPECT_LE(((A * B).full() - (complex_a * complex_b).full()).norm(),
+              1e-12);
+    EXPECT_TRUE((A + B).isReal());
+    EXPECT_FALSE((A + complex_b).isReal());
+    EXPECT_TRUE((complex<double>(2) * A).isReal());
+    EXPECT_FALSE((complex<double>(0, 1) * A).isReal());
+
+    EXPECT_TRUE(A.inverse().isReal());
+    EXPECT_LE((A.inverse().full() - complex_a.inverse().full()).norm(),
+              1e-12);
+    EXPECT_TRUE(A.solve(B).isReal());
+    EXPECT_LE((A.solve(B).full() - complex_a.solve(complex_b).full()).norm(),
+              1e-12);
+    EXPECT_TRUE(A.power(3).isReal());
+    EXPECT_LE((A.power(3).full() - complex_a.power(3).full()).norm(), 1e-9);
+
+    vector<complex<double> > c(3, 0.5);
+    EXPECT_TRUE(A.polynomial(c).isReal());
+    EXPECT_LE((A.polynomial(c).full()
+               - complex_a.polynomial(c).full()).norm(), 1e-10);
+    c[1] = complex<double>(0, 1);
+    EXPECT_FALSE(A.polynomial(c).isReal());
+    EXPECT_LE((A.polynomial(c).full()
+               - complex_a.polynomial(c).full()).norm(), 1e-10);
+
+    EXPECT_NEAR(complex_a.spectral_radius(), A.spectral_radius(), 1e-10);
+    // the eigenvalues of a real matrix come in conjugate pairs, whose real
+    // parts are only equal up to rounding in complex arithmetic, hence,
+    // the eigenvalues are matched by distance instead of by sorting
+    VectorXcd ews = A.eigenvalues();
+    VectorXcd complex_ews = complex_a.eigenvalues();
+    for (int i = 0; i < ews.size(); ++i) {
+        EXPECT_NEAR(0, (complex_ews.array() - ews[i]).abs().minCoeff(),
+                    1e-10);
+    }
+
+    // writing may destroy the structure
+    A.forgetStructure();
+    EXPECT_FALSE(A.isReal());
+}
+
+TEST(BdMatrix, RealEigenvalues)
+{
+    const int n = 32;
+    const int m = 8;
+    BdMatrix A(n, m, m);
+    for (int b = 0; b < n; ++b)
+        A.set_block(b, MatrixXd::Random(m, m).cast<complex<double> >());
+    A.setReal(true);
+
+    // dgeev returns the complex eigenvalues of a real matrix as exact
+    // conjugate pairs, which shows that the real path is taken
+    VectorXcd ews = A.eigenvalues();
+    int pairs = 0;
+    for (int i = 0; i + 1 < ews.size(); ++i) {
+        if (imag(ews[i]) > 0) {
+            EXPECT_EQ(conj(ews[i]), ews[i + 1]);
+            ++pairs;
+        }
+    }
+    EXPECT_LT(0, pairs);
+}
+
+TEST(BdMatrix, EigenvaluesOfVaryingSize)
+{
+    // the cached LAPACK workspaces have to adapt to the block size
+    for (int n = 1; n <= 5; ++n) {
+        BdMatrix M(8, n, n);
+        for (int b = 0; b < M.no_blocks(); ++b) {
+            MatrixXcd A = MatrixXcd::Zero(n, n);
+            for (int i = 0; i < n; ++i) {
+                A(i, i) = b + i;
+            }
+            M.set_block(b, A);
+        }
+
+        VectorXcd ews = M.eigenvalues();
+        for (int b = 0; b < M.no_blocks(); ++b) {
+            std::sort(ews.data() + n*b, ews.data() + n*(b+1), cmplx_lex_less);
+            for (int i = 0; i < n; ++i) {
+                EXPECT_NEAR(b + i, real(ews(n*b + i)), 1e-10);
+            }
+        }
+    }
+}
+
+
+TEST(BdMatrix, ReusedEigenvalueSolver)
+{
+    EigenvalueSolver solver;
+
+    for (int n = 3; n >= 1; --n) {
+        for (int k = 0; k < 2; ++k) {
+            MatrixXcd A = MatrixXcd::Zero(n, n);
+            for (int i = 0; i < n; ++i) {
+                A(i, i) = complex<double>(k + i, 1);
+            }
+
+            VectorXcd ews = solver.eigenvalues(A);
+            EXPECT_EQ(n, solver.size());
+            std::sort(ews.data(), ews.data() + n, cmplx_lex_less);
+            for (int i = 0; i < n; ++i) {
+                EXPECT_NEAR(k + i, real(ews(i)), 1e-10);
+                EXPECT_NEAR(1, imag(ews(i)), 1e-10);
+            }
+        }
+    }
+
+    EXPECT_THROW(solver.eigenvalues(MatrixXcd::Zero(2, 3)), logic_error);
+}
+
+TEST(BdMatrix, SpectralNorm)
+{
+    // small blocks use an SVD, large blocks the Lanczos bidiagonalization
+    int sizes[] = { 1, 5, 40 };
+    for (int s = 0; s < 3; ++s) {
+        int n = sizes[s];
+        BdMatrix M(3, n, n);
+        double expected = 0;
+        for (int b = 0; b < M.no_blocks(); ++b) {
+            MatrixXcd A = MatrixXcd::Random(n, n);
+            M.set_block(b, A);
+
+            JacobiSVD<MatrixXcd> svd(A);
+            expected = std::max(expected, svd.singularValues()(0));
+        }
+
+        EXPECT_NEAR(expected, M.spectral_norm(), 1e-8 * expected);
+    }
+
+    // a rectangular matrix and a repeated largest singular value
+    MatrixXcd R = MatrixXcd::Random(50, 40);
+    EXPECT_NEAR(JacobiSVD<MatrixXcd>(R).singularValues()(0),
+                singular_value_max(R), 1e-8);
+    EXPECT_NEAR(2, singular_value_max(2.0 * MatrixXcd::Identity(40, 40)),
+                1e-12);
+    EXPECT_EQ(0, singular_value_max(MatrixXcd::Zero(40, 40)));
+}
+
+TEST(BdMatrix, SpectralNormOfCluster)
+{
+    // the two largest singular values are nearly equal, as for the
+    // symmetric harmonics of a symbol
+    const int n = 64;
+    VectorXd sigma = 0.5 * (VectorXd::Random(n).array() + 1.0);
+    sigma(0) = 2.0;
+    sigma(1) = 2.0 * (1 - 1e-10);
+    sigma(2) = 2.0 * (1 - 1e-9);
+
+    HouseholderQR<MatrixXcd> q(MatrixXcd::Random(n, n));
+    HouseholderQR<MatrixXcd> p(MatrixXcd::Random(n, n));
+    MatrixXcd Q = q.householderQ();
+    MatrixXcd P = p.householderQ();
+    MatrixXcd A = Q * sigma.cast<complex<double> >().asDiagonal()
+                  * P.adjoint();
+
+    // the iteration stops early instead of running to the exact result
+    int steps = 0;
+    EXPECT_NEAR(2.0, singular_value_max(A, &steps), 1e-8);
+    EXPECT_LT(0, steps);
+    EXPECT_LT(steps, n / 2);
+}
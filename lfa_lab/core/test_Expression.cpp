@@ -0,0 +1,566 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+
+#include "Expression.h"
+#include "DagEvaluator.h"
+#include "SymbolCache.h"
+#include "Simplifier.h"
+#include "ExpressionSb.h"
+#include "BlockSb.h"
+#include "StencilGallery.h"
+#include "HpFilterSb.h"
+#include "LazySymbol.h"
+
+using namespace lfa;
+
+namespace {
+
+    /** Counts how often its symbol is generated. */
+    class CountingSb : public SymbolBuilder {
+        public:
+            CountingSb(Grid grid)
+                : count(0),
+                  m_stencil(stencil_poisson2d(grid.step_size()), grid)
+            { }
+
+            FoProperties properties() { return m_stencil.properties(); }
+
+            Symbol generate(const SamplingProperties& conf) {
+                ++count;
+                return m_stencil.generate(conf);
+            }
+
+            int count;
+        private:
+            FoStencil m_stencil;
+    };
+
+    /** Check that the symbol of the expression is computed from the
+     * frequencies that are even along the given dimension, and that it
+     * coincides with the clusters that a LazySymbol samples separately. */
+    void expect_conjugate_halving(Expression E,
+                                  const SamplingProperties& conf,
+                                  int dim)
+    {
+        DagEvaluator evaluator(E.simplified().builder());
+        EXPECT_EQ(dim, evaluator.conjugateDimension(conf));
+        Symbol halved = evaluator.evaluate(conf);
+
+        LazySymbol lazy(E, conf);
+        NdRange bases = lazy.baseIndices();
+        ASSERT_EQ(bases.size(), halved.baseIndices().size());
+        for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+            Symbol cluster = lazy.cluster(*b);
+            EXPECT_LE((cluster.matrix().block(0)
+                       - halved.fullCluster(*b)).norm(), 1e-10);
+        }
+    }
+
+}
+
+TEST(Expression, SharedSubexpressions)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+
+    shared_ptr<CountingSb> counting(new CountingSb(grid));
+    Expression A(counting);
+    Expression I = Expression::Identity(grid);
+
+    // A occurs four times, but is only generated once
+    Expression B = (I + A) * (I - A);
+    Expression E = B * (A * A) + B;
+
+    DagEvaluator evaluator(E.builder());
+    EXPECT_EQ(9, evaluator.size());
+
+    Symbol result = evaluator.evaluate(conf);
+    EXPECT_EQ(1, counting->count);
+
+    Symbol a = A.symbol(conf);
+    Symbol id = Symbol::Identity(grid, conf);
+    Symbol b = (id + a) * (id - a);
+    Symbol expected = b * (a * a) + b;
+
+    EXPECT_LE((result.full() - expected.full()).norm(), 1e-10);
+}
+
+TEST(Expression, Block)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+
+    DenseStencil L = stencil_poisson2d(grid.step_size());
+    DenseStencil D = L.diag();
+
+    // L on the diagonal of the 2x2 pattern, D off the diagonal
+    NdArray<Expression> scalars(ArrayFi::Constant(2, 2));
+    NdRange pattern = scalars.indices();
+    for (NdRange::iterator p = pattern.begin(); p != pattern.end(); ++p) {
+        scalars(*p) = FoStencil((*p)(0) == (*p)(1) ? L : D, grid);
+    }
+
+    Expression block = Expression::Block(scalars);
+
+    // the same operator, using the precomputed scalar symbols
+    NdArray<Symbol> symbols(ArrayFi::Constant(2, 2));
+    NdRange indices = symbols.indices();
+    for (NdRange::iterator p = indices.begin(); p != indices.end(); ++p) {
+        symbols(*p) = scalars(*p).symbol(conf);
+    }
+    BlockSb sb(grid, ArrayFi::Constant(2, 2));
+    sb.scalarSymbols(symbols);
+
+    EXPECT_LE((block.symbol(conf).full() - sb.generate(conf).full()).norm(),
+              1e-10);
+    EXPECT_THROW(Expression::Block(NdArray<Expression>(ArrayFi::Ones(2))),
+                 logic_error);
+}
+
+TEST(Expression, StructuralEquality)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    Grid other_step(2, ArrayFd::Constant(2, 1.0 / 16));
+    DenseStencil L = stencil_poisson2d(grid.step_size());
+
+    // separately constructed, but equal operators are merged
+    Expression A1 = FoStencil(L, grid);
+    Expression A2 = FoStencil(L, grid);
+    Expression A3 = FoStencil(L, other_step);
+    Expression I = Expression::Identity(grid);
+
+    EXPECT_TRUE(structurally_equal(*(I - A1).builder(), *(I - A2).builder()));
+    EXPECT_EQ(structural_hash(*(I - A1).builder()),
+              structural_hash(*(I - A2).builder()));
+    EXPECT_FALSE(structurally_equal(*(I - A1).builder(),
+                                    *(I - A3).builder()));
+    EXPECT_FALSE(structurally_equal(*(I - A1).builder(),
+                                    *(I - 0.5 * A1).builder()));
+
+    // I, A, -A, I-A, and the product
+    DagEvaluator evaluator(((I - A1) * (I - A2)).builder());
+    EXPECT_EQ(5, evaluator.size());
+}
+
+TEST(Expression, DeepSharedTraversal)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+    DenseStencil L = stencil_poisson2d(grid.step_size());
+
+    // 2^64 paths through 65 nodes, every traversal has to visit a shared
+    // node only once
+    Expression E1 = FoStencil(L, grid);
+    Expression E2 = FoStencil(L, grid);
+    for (int i = 0; i < 64; ++i) {
+        E1 = E1 * E1;
+        E2 = E2 * E2;
+    }
+
+    EXPECT_EQ(structural_hash(*E1.builder()), structural_hash(*E2.builder()));
+    EXPECT_TRUE(structurally_equal(*E1.builder(), *E2.builder()));
+    EXPECT_TRUE(has_real_coefficients(*E1.builder(), conf));
+}
+
+TEST(Expression, SymbolCache)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+    SamplingProperties other_conf(ArrayFi::Constant(2, 16), grid);
+
+    shared_ptr<CountingSb> counting(new CountingSb(grid));
+    Expression A(counting);
+    Expression I = Expression::Identity(grid);
+
+    SymbolCache cache;
+    Symbol first = DagEvaluator((I - A).builder()).evaluate(conf, &cache);
+    EXPECT_EQ(1, counting->count);
+    EXPECT_EQ(4, cache.size());
+
+    // a new, but equal expression reuses the symbols
+    Expression E = Expression::Identity(grid) - A;
+    Symbol second = DagEvaluator(E.builder()).evaluate(conf, &cache);
+    EXPECT_EQ(1, counting->count);
+    EXPECT_EQ(4, cache.size());
+    EXPECT_LE((first.full() - second.full()).norm(), 1e-14);
+
+    // a partially cached expression; only the new nodes are computed
+    DagEvaluator(((I - A) * A).builder()).evaluate(conf, &cache);
+    EXPECT_EQ(1, counting->count);
+    EXPECT_EQ(5, cache.size());
+
+    // a different sampling
+    DagEvaluator(A.builder()).evaluate(other_conf, &cache);
+    EXPECT_EQ(2, counting->count);
+
+    cache.setCapacity(0);
+    EXPECT_EQ(0, cache.size());
+    EXPECT_EQ(0u, cache.memory());
+}
+
+TEST(Expression, SymbolCacheEvictsLeastRecentlyUsed)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+    ArrayFi factor = ArrayFi::Ones(2);
+
+    SymbolBuilderPtr id(new IdentitySb(grid));
+    Symbol sym = id->generate(conf);
+
+    // room for two symbols
+    SymbolCache cache;
+    cache.insert(1, id, conf, factor, sym);
+    cache.setCapacity(2 * cache.memory());
+    cache.insert(2, id, conf, factor, sym);
+
+    // using the first symbol keeps it, the second one is evicted instead
+    Symbol found;
+    EXPECT_TRUE(cache.lookup(1, *id, conf, factor, found));
+    EXPECT_LE((found.full() - sym.full()).norm(), 0.0);
+    cache.insert(3, id, conf, factor, sym);
+    EXPECT_EQ(2, cache.size());
+    EXPECT_TRUE(cache.lookup(1, *id, conf, factor, found));
+    EXPECT_FALSE(cache.lookup(2, *id, conf, factor, found));
+    EXPECT_TRUE(cache.lookup(3, *id, conf, factor, found));
+}
+
+TEST(Expression, SymbolCacheThreads)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+    ArrayFi factor = ArrayFi::Ones(2);
+
+    SymbolBuilderPtr id(new IdentitySb(grid));
+    Symbol sym = id->generate(conf);
+
+    // room for three symbols, used by threads that are not OpenMP threads
+    SymbolCache cache;
+    cache.insert(0, id, conf, factor, sym);
+    size_t bytes = cache.memory();
+    cache.setCapacity(3 * bytes);
+
+    vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([&cache, &id, &conf, &factor, &sym, t]
+        {
+            Symbol found;
+            for (int i = 0; i < 200; ++i) {
+                size_t hash = (t * 200 + i) % 7;
+                if (!cache.lookup(hash, *id, conf, factor, found))
+                    cache.insert(hash, id, conf, factor, sym);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+        threads[t].join();
+
+    EXPECT_LE(cache.size(), 3);
+    EXPECT_EQ(cache.size() * bytes, cache.memory());
+}
+
+TEST(Expression, Simplify)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    Grid coarse = grid.coarse(ArrayFi::Constant(2, 2));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+    SparseStencil L = stencil_poisson2d(grid.step_size());
+
+    SparseStencil diagonal;
+    for (int i = 0; i < L.nonZeros(); ++i) {
+        if ((L[i].offset == 0).all())
+            diagonal.append(L[i].offset, L[i].value);
+    }
+
+    Expression A = FoStencil(L, grid);
+    Expression D = FoStencil(diagonal, grid);
+    Expression I = Expression::Identity(grid);
+    Expression Ac = FoStencil(stencil_poisson2d(coarse.step_size()), coarse);
+    Expression R = Expression(flat_restriction_sb(coarse, grid))
+        * FoStencil(fw_restriction(2), grid);
+
+    // the Jacobi iteration becomes a single stencil
+    Expression S = I - 0.8 * D.inverse() * A;
+    EXPECT_EQ(1, DagEvaluator(S.simplified().builder()).size());
+
+    // the adjoint is pushed down to the stencils: S^H, A^H, and two
+    // products
+    Expression T = (S * A * S).adjoint();
+    EXPECT_EQ(4, DagEvaluator(T.simplified().builder()).size());
+
+    // a rectangular operator: restriction and interpolation
+    Expression P = (2.0 * R).adjoint();
+    Expression E = (S * S) * (I - P * Ac.inverse() * R * A)
+                   + Expression::Zero(grid) * T;
+
+    Expression exprs[] = { S, T, E };
+    for (int i = 0; i < 3; ++i) {
+        Symbol expected = DagEvaluator(exprs[i].builder()).evaluate(conf);
+        Symbol result = exprs[i].symbol(conf);
+        EXPECT_LE((expected.full() - result.full()).norm(), 1e-10);
+    }
+
+    // identities, double adjoints, and scalars are removed
+    shared_ptr<CountingSb> counting(new CountingSb(grid));
+    Expression C(counting);
+    Expression F = (2.0 * (0.5 * C.adjoint().adjoint())) * I
+                   + Expression::Zero(grid);
+    EXPECT_EQ(counting, F.simplified().builder());
+}
+
+namespace {
+
+    /** The estimated cost of all products in the graph. */
+    double total_product_cost(SymbolBuilderPtr root)
+    {
+        double cost = 0;
+
+        std::vector<SymbolBuilderPtr> stack(1, root);
+        std::set<SymbolBuilder*> visited;
+        while (!stack.empty()) {
+            SymbolBuilderPtr b = stack.back();
+            stack.pop_back();
+            if (!visited.insert(b.get()).second)
+                continue;
+
+            if (ProductSb* p = dynamic_cast<ProductSb*>(b.get()))
+                cost += product_cost(p->lhs()->properties(),
+                                     p->rhs()->properties());
+
+            std::vector<SymbolBuilderPtr> deps = b->dependencies();
+            stack.insert(stack.end(), deps.begin(), deps.end());
+        }
+
+        return cost;
+    }
+
+}
+
+TEST(Expression, ProductOrdering)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), fine);
+
+    Expression A = FoStencil(stencil_poisson2d(fine.step_size()), fine);
+    Expression Ac = FoStencil(stencil_poisson2d(coarse.step_size()), coarse);
+    Expression P = Expression(FoStencil(ml_interpolation_stencil(2), fine))
+        * flat_interpolation_sb(fine, coarse);
+    Expression R = Expression(flat_restriction_sb(coarse, fine))
+        * FoStencil(fw_restriction(2), fine);
+
+    // evaluated from left to right, the 4x4 blocks of A are multiplied
+    // with the 4x1 blocks of P Ac^-1 R
+    Expression C = P * Ac.inverse() * R * A;
+    Expression S = C.simplified();
+
+    EXPECT_LT(total_product_cost(S.builder()),
+              total_product_cost(C.builder()));
+
+    Symbol expected = DagEvaluator(C.builder()).evaluate(conf);
+    Symbol result = DagEvaluator(S.builder()).evaluate(conf);
+    EXPECT_LE((expected.full() - result.full()).norm(), 1e-10);
+}
+
+TEST(Expression, GenerateExpanded)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), fine);
+    ArrayFi factor(2);
+    factor << 2, 4;
+
+    FoStencil A(stencil_poisson2d(fine.step_size()), fine);
+    ConstantSb R = flat_restriction_sb(coarse, fine);
+    HpFilterSb H(fine, coarse);
+    IdentitySb I(fine);
+
+    SymbolBuilder* builders[] = { &A, &R, &H, &I };
+    for (int i = 0; i < 4; ++i) {
+        Symbol expected = builders[i]->generate(conf).expand(factor);
+        Symbol result = builders[i]->generateExpanded(conf, factor);
+
+        ASSERT_TRUE(expected.outputClusters() == result.outputClusters());
+        ASSERT_TRUE(expected.inputClusters() == result.inputClusters());
+        EXPECT_LE((expected.full() - result.full()).norm(), 1e-14);
+    }
+
+    // A is generated with merged clusters, since R needs them
+    Expression E = Expression(R) * A * Expression(flat_interpolation_sb(
+                fine, coarse));
+    Symbol expected = E.builder()->generate(conf);
+    Symbol result = DagEvaluator(E.builder()).evaluate(conf);
+    EXPECT_LE((expected.full() - result.full()).norm(), 1e-12);
+}
+
+TEST(Expression, ParameterSweep)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+
+    shared_ptr<CountingSb> counting(new CountingSb(grid));
+    Expression A(counting);
+    Expression I = Expression::Identity(grid);
+    Expression D(FoStencil(stencil_poisson2d(grid.step_size()).diag(),
+                           grid));
+
+    // the damped Jacobi error propagator
+    Expression S = I - (D.inverse() * A).parameterized("omega", 1.0);
+    Expression E = S * S;
+
+    vector<ParameterValues> points;
+    complex<double> omegas[] = { 0.5, 0.8, 1.0 };
+    for (int i = 0; i < 3; ++i) {
+        ParameterValues point;
+        point["omega"] = omegas[i];
+        points.push_back(point);
+    }
+
+    DagEvaluator evaluator(simplify(E.builder()));
+    ASSERT_EQ(1u, evaluator.parameters().size());
+    EXPECT_EQ("omega", evaluator.parameters()[0]);
+
+    vector<Symbol> symbols = evaluator.sweep(conf, points);
+    ASSERT_EQ(3u, symbols.size());
+    EXPECT_EQ(1, counting->count);
+
+    Symbol a = A.symbol(conf);
+    Symbol d_inv = D.symbol(conf).inverse();
+    Symbol id = Symbol::Identity(grid, conf);
+    for (int i = 0; i < 3; ++i) {
+        Symbol s = id - omegas[i] * (d_inv * a);
+        Symbol expected = s * s;
+        EXPECT_LE((symbols[i].full() - expected.full()).norm(), 1e-10);
+    }
+
+    // the default value is used, if the parameter is not given
+    EXPECT_LE((E.symbol(conf).full() - symbols[2].full()).norm(), 1e-10);
+
+    ParameterSweep sweep(E, conf);
+    sweep.set("omega", 0.5);
+    EXPECT_LE((sweep.symbol().full() - symbols[0].full()).norm(), 1e-10);
+    EXPECT_THROW(sweep.set("nu", 1.0), logic_error);
+
+    // an expression without parameters gives the same symbol every time
+    vector<Symbol> constant = A.sweep(conf, points);
+    ASSERT_EQ(3u, constant.size());
+    EXPECT_LE((constant[1].full() - a.full()).norm(), 1e-10);
+}
+
+TEST(Expression, PowerAndPolynomial)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+
+    Expression I = Expression::Identity(grid);
+    Expression A(FoStencil(stencil_poisson2d(grid.step_size()), grid));
+    // the Richardson iteration, its eigenvalues are in [0, 1]
+    Expression S = I - (1.0 / 512) * A;
+
+    Symbol s = S.symbol(conf);
+    Symbol expected = s;
+    for (int p = 1; p < 8; ++p) {
+        expected = expected * s;
+    }
+    EXPECT_LE((S.power(8).symbol(conf).full() - expected.full()).norm(),
+              1e-10);
+
+    // trivial powers and scalars are simplified away
+    EXPECT_TRUE(dynamic_cast<IdentitySb*>(
+                S.power(0).simplified().builder().get()));
+    EXPECT_EQ(A.builder(), A.power(1).simplified().builder());
+    EXPECT_TRUE(dynamic_cast<ScaledSb*>(
+                (2.0 * (A * A)).power(3).simplified().builder().get()));
+
+    // S + S^2 / 2
+    vector<complex<double> > c(3);
+    c[1] = 1.0;
+    c[2] = 0.5;
+    Symbol poly = S.polynomial(c).symbol(conf);
+    EXPECT_LE((poly.full() - (s + 0.5 * (s * s)).full()).norm(), 1e-10);
+}
+
+TEST(Expression, Solve)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 8));
+    Grid coarse = grid.coarse(ArrayFi::Constant(2, 2));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), grid);
+
+    DenseStencil L = stencil_poisson2d(grid.step_size());
+    Expression A(FoStencil(L, grid));
+    Expression M = Expression::Identity(grid) + (1.0 / 512) * A;
+    Expression E = M.inverse() * A;
+
+    // the inverse is not formed
+    SymbolBuilderPtr simplified = E.simplified().builder();
+    SolveSb* solve = dynamic_cast<SolveSb*>(simplified.get());
+    ASSERT_TRUE(solve);
+    EXPECT_TRUE(dynamic_cast<FoStencil*>(solve->op().get()));
+
+    Symbol expected = M.symbol(conf).inverse() * A.symbol(conf);
+    EXPECT_LE((E.symbol(conf).full() - expected.full()).norm(), 1e-10);
+
+    // the clusters of the operands differ in the coarse grid correction
+    Expression R(flat_restriction_sb(coarse, grid));
+    Expression P(flat_interpolation_sb(grid, coarse));
+    Expression Ac = R * A * P;
+    Expression C = Ac.inverse() * R * A;
+
+    expected = Ac.symbol(conf).inverse() * (R * A).symbol(conf);
+    EXPECT_LE((C.symbol(conf).full() - expected.full()).norm(), 1e-8);
+}
+
+TEST(Expression, ConjugateHalving)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+    // the first dimension has an odd number of clusters
+    ArrayFi resolution(2);
+    resolution << 6, 8;
+    SamplingProperties conf(resolution, fine);
+
+    Expression A = FoStencil(stencil_poisson2d(fine.step_size()), fine);
+    Expression Ac = FoStencil(stencil_poisson2d(coarse.step_size()), coarse);
+    Expression P = Expression(FoStencil(ml_interpolation_stencil(2), fine))
+        * flat_interpolation_sb(fine, coarse);
+    Expression R = Expression(flat_restriction_sb(coarse, fine))
+        * FoStencil(fw_restriction(2), fine);
+
+    // the clusters of the rows and the columns differ in the restriction
+    expect_conjugate_halving(R * A, conf, 1);
+    expect_conjugate_halving(A - A * P * Ac.inverse() * R * A, conf, 1);
+
+    // the high-pass filter requires a resolution that does not sample the
+    // boundary of the low frequencies
+    Expression hp = HpFilterSb(fine, coarse);
+    EXPECT_EQ(-1, DagEvaluator((hp * A).builder()).conjugateDimension(conf));
+    SamplingProperties even(ArrayFi::Constant(2, 8), fine);
+    expect_conjugate_halving(hp * A, even, 0);
+
+    // complex coefficients, and a sampling without the negative
+    // frequencies
+    EXPECT_EQ(-1, DagEvaluator((complex<double>(0, 1) * A).builder())
+              .conjugateDimension(conf));
+    SamplingProperties shifted(resolution, ArrayFd::Constant(2, 0.1));
+    EXPECT_EQ(-1, DagEvaluator(A.builder()).conjugateDimension(shifted));
+}
@@ -21,9 +21,38 @@
 
 #include "MathUtil.h"
 #include "NdRange.h"
+#include "Fft.h"
+#include "FixedDimension.h"
+#include "Parallel.h"
 
 using namespace lfa;
 
+namespace {
+
+    /** Visits a range with the specialised index type of dimension D. */
+    struct VisitRange {
+        VisitRange(ArrayFi shape) : shape(shape), dimension(0) { }
+
+        template <int D>
+        void run()
+        {
+            typedef typename FixedIndex<D>::type Index;
+            dimension = D;
+
+            Index s = shape;
+            Index g = Index::Zero(fixed_dimension<D>(shape.size()));
+            do {
+                visited.push_back(dynamic_index<D>(g));
+            } while (next_index<D>(g, s));
+        }
+
+        ArrayFi shape;
+        int dimension;
+        vector<ArrayFi> visited;
+    };
+
+}
+
 #include <iterator>
 #include <algorithm>
 
@@ -66,3 +95,97 @@ TEST(General, grid)
     EXPECT_EQ(i, 6);
 }
 
+
+TEST(General, Fft)
+{
+    int lengths[] = { 1, 2, 6, 8, 12, 7, 49, 60 };
+    for (int l = 0; l < 8; ++l) {
+        int n = lengths[l];
+        VectorXcd x(n);
+        for (int j = 0; j < n; ++j) {
+            x[j] = complex<double>(sin(j + 1.0), cos(2.0 * j));
+        }
+
+        for (int sign = -1; sign <= 1; sign += 2) {
+            VectorXcd y(n);
+            Fft(n, sign).transform(x.data(), y.data());
+
+            for (int k = 0; k < n; ++k) {
+                complex<double> expected = 0;
+                for (int j = 0; j < n; ++j) {
+                    expected += x[j] * exp(complex<double>(
+                                0, sign * 2.0 * pi * j * k / n));
+                }
+                EXPECT_LE(std::abs(y[k] - expected), 1e-10 * n);
+            }
+        }
+    }
+
+    // a two-dimensional transform is a transform of the rows and columns
+    MatrixXcd A(6, 4);
+    for (int i = 0; i < 6; ++i)
+        for (int j = 0; j < 4; ++j)
+            A(i, j) = complex<double>(i, j * j);
+
+    MatrixXcd F0(6, 6), F1(4, 4);
+    for (int i = 0; i < 6; ++i)
+        for (int j = 0; j < 6; ++j)
+            F0(i, j) = exp(complex<double>(0, -2.0 * pi * i * j / 6));
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            F1(i, j) = exp(complex<double>(0, -2.0 * pi * i * j / 4));
+
+    MatrixXcd expected = F0 * A * F1.transpose();
+    ArrayFi shape(2);
+    shape << 6, 4;
+    fft_nd(A.data(), shape);
+    EXPECT_LE((A - expected).norm(), 1e-10);
+
+    // the factors 4 first, then the primes
+    EXPECT_EQ(0, fft_radix_sum(1));
+    EXPECT_EQ(4 + 4 + 2, fft_radix_sum(32));
+    EXPECT_EQ(4 + 3, fft_radix_sum(12));
+    EXPECT_EQ(127, fft_radix_sum(127));
+}
+
+
+TEST(General, FixedDimension)
+{
+    for (int d = 1; d <= 4; ++d) {
+        ArrayFi shape(d);
+        for (int j = 0; j < d; ++j)
+            shape[j] = j + 2;
+
+        VisitRange kernel(shape);
+        dispatch_dimension(d, kernel);
+
+        EXPECT_EQ(kernel.dimension, d <= 3 ? d : int(Dynamic));
+
+        // the indices are visited in the order of NdRange
+        NdRange range(shape);
+        ASSERT_EQ(int(kernel.visited.size()), range.size());
+        for (int i = 0; i < int(range.size()); ++i) {
+            EXPECT_TRUE((kernel.visited[i] == range.coordOf(i)).all());
+        }
+    }
+}
+
+TEST(General, ParallelErrors)
+{
+    ParallelErrors errors;
+    EXPECT_FALSE(errors.failed());
+    errors.rethrow();
+
+    #pragma omp parallel for
+    for (int i = 0; i < 8; ++i) {
+        try {
+            throw out_of_range("index out of range");
+        } catch (...) {
+            errors.capture();
+        }
+    }
+
+    // the captured exception keeps its type
+    EXPECT_TRUE(errors.failed());
+    EXPECT_THROW(errors.rethrow(), out_of_range);
+}
@@ -138,6 +138,30 @@ TEST(Harmonics, HarmonicClusters)
     }
 }
 
+TEST(Harmonics, IndexTable)
+{
+    ArrayFi H(3), B(3);
+
+    H << 2, 3, 1;
+    B << 3, 2, 4;
+    HarmonicClusters clusters(B, H);
+    HarmonicIndexTable table = clusters.indexTable();
+
+    NdRange bases = clusters.baseIndices();
+    NdRange cluster_indices = clusters.clusterIndices();
+    NdRange global = clusters.globalIndices();
+
+    ASSERT_EQ(table.baseSize(), bases.size());
+    ASSERT_EQ(table.clusterSize(), cluster_indices.size());
+
+    for (int b = 0; b < int(bases.size()); ++b) {
+        for (int c = 0; c < int(cluster_indices.size()); ++c) {
+            ArrayFi g = clusters.globalIndex(bases.coordOf(b),
+                                             cluster_indices.coordOf(c));
+            EXPECT_EQ(table.global(b, c), global.indexOf(g));
+        }
+    }
+}
 
 
 TEST(Harmonics, ClusterSanity)
@@ -0,0 +1,159 @@
+/*
+  LFA Lab - Library to simplify local Fourier analysis.
+  Copyright (C) 2018  Hannah Rittich
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include "LazySymbol.h"
+#include "StencilGallery.h"
+#include "HpFilterSb.h"
+
+using namespace lfa;
+
+namespace {
+
+    /** Error propagator of a two-grid method with Jacobi smoothing. */
+    Expression two_grid_operator(Grid fine, Grid coarse)
+    {
+        ArrayFd h = fine.step_size();
+
+        Expression A = FoStencil(stencil_poisson2d(h), fine);
+        Expression Ac = FoStencil(stencil_poisson2d(coarse.step_size()),
+                                  coarse);
+
+        Expression P = Expression(FoStencil(ml_interpolation_stencil(2), fine))
+            * flat_interpolation_sb(fine, coarse);
+        Expression R = Expression(flat_restriction_sb(coarse, fine))
+            * FoStencil(fw_restriction(2), fine);
+
+        Expression I = Expression::Identity(fine);
+        double omega = 0.8 / (2.0 / (h(0)*h(0)) + 2.0 / (h(1)*h(1)));
+        Expression S = I - omega * A;
+
+        return S * (I - P * Ac.inverse() * R * A) * S;
+    }
+
+}
+
+TEST(LazySymbol, TwoGrid)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+
+    Expression E = two_grid_operator(fine, coarse);
+    ArrayFi resolution =
+        E.properties().adjustResolution(ArrayFi::Constant(2, 8));
+    SamplingProperties conf(resolution, fine);
+
+    Symbol full = E.symbol(conf);
+    LazySymbol lazy(E, conf);
+
+    // only half of the clusters are evaluated
+    EXPECT_TRUE(lazy.isConjugateSymmetric());
+    EXPECT_EQ(full.baseIndices().size(), lazy.baseIndices().size());
+    EXPECT_NEAR(full.spectral_radius(), lazy.spectral_radius(), 1e-12);
+    EXPECT_NEAR(full.spectral_norm(), lazy.spectral_norm(), 1e-12);
+
+    // every cluster coincides with the corresponding one of the full symbol
+    NdRange bases = lazy.baseIndices();
+    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+        Symbol cluster = lazy.cluster(*b);
+        ASSERT_EQ(1, cluster.matrix().no_blocks());
+        EXPECT_LE((cluster.matrix().block(0) - full.fullCluster(*b)).norm(),
+                  1e-12);
+    }
+
+    // the eigenvalues agree as a set
+    VectorXcd ev_full = full.eigenvalues();
+    VectorXcd ev_lazy = lazy.eigenvalues();
+    ASSERT_EQ(ev_full.size(), ev_lazy.size());
+
+    std::vector<double> abs_full(ev_full.size()), abs_lazy(ev_lazy.size());
+    for (int i = 0; i < ev_full.size(); ++i) {
+        abs_full[i] = abs(ev_full(i));
+        abs_lazy[i] = abs(ev_lazy(i));
+    }
+    std::sort(abs_full.begin(), abs_full.end());
+    std::sort(abs_lazy.begin(), abs_lazy.end());
+    for (size_t i = 0; i < abs_full.size(); ++i) {
+        EXPECT_NEAR(abs_full[i], abs_lazy[i], 1e-10);
+    }
+}
+
+TEST(LazySymbol, ConjugateSymmetry)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+
+    Expression E = two_grid_operator(fine, coarse);
+    ArrayFi resolution =
+        E.properties().adjustResolution(ArrayFi::Constant(2, 8));
+    SamplingProperties conf(resolution, fine);
+    LazySymbol lazy(E, conf);
+    ASSERT_TRUE(lazy.isConjugateSymmetric());
+
+    // the cluster of the conjugate base has the conjugate eigenvalues
+    NdRange bases = lazy.baseIndices();
+    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+        ArrayFi c = lazy.conjugateBase(*b);
+        EXPECT_TRUE((lazy.conjugateBase(c) == *b).all());
+
+        VectorXcd ev = lazy.cluster(*b).eigenvalues();
+        VectorXcd ev_conj = lazy.cluster(c).eigenvalues();
+        for (int i = 0; i < ev.size(); ++i) {
+            EXPECT_NEAR(0, (ev_conj.array() - conj(ev(i))).abs().minCoeff(),
+                        1e-10);
+        }
+    }
+
+    // complex coefficients
+    Expression A = FoStencil(stencil_poisson2d(fine.step_size()), fine);
+    EXPECT_FALSE(LazySymbol(complex<double>(0, 1) * A, conf)
+                 .isConjugateSymmetric());
+    EXPECT_TRUE(LazySymbol(2.0 * A, conf).isConjugateSymmetric());
+
+    // a sampling without the negative frequencies
+    SamplingProperties shifted(resolution, ArrayFd::Constant(2, 0.1));
+    EXPECT_FALSE(LazySymbol(A, shifted).isConjugateSymmetric());
+
+    // Sampling the zero frequency is symmetric, but the high-pass filter
+    // classifies the frequencies on the boundary differently.
+    SamplingProperties zero(resolution, ArrayFd::Zero(2));
+    EXPECT_TRUE(LazySymbol(A, zero).isConjugateSymmetric());
+    Expression hp = HpFilterSb(fine, coarse);
+    EXPECT_FALSE(LazySymbol(hp * A, zero).isConjugateSymmetric());
+    EXPECT_TRUE(LazySymbol(hp * A, conf).isConjugateSymmetric());
+    EXPECT_NEAR((hp * A).symbol(conf).spectral_radius(),
+                LazySymbol(hp * A, conf).spectral_radius(), 1e-10);
+}
+
+TEST(LazySymbol, InvalidResolution)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+
+    Expression P = Expression(FoStencil(ml_interpolation_stencil(2), fine))
+        * flat_interpolation_sb(fine, coarse);
+
+    // the interpolation requires an even resolution
+    ArrayFi resolution(2);
+    resolution << 7, 8;
+    SamplingProperties conf(resolution, fine);
+    EXPECT_THROW(LazySymbol(P, conf), logic_error);
+}
@@ -26,7 +26,38 @@ TEST(SparseStencil, append_dimension_fail)
 {
     SparseStencil s;
 
-    s.append(Array2i(0, 0), 1);
+    s.append(ArrayFi::Zero(2), 1);
 
-    ASSERT_THROW(s.append(Array3i(1,1,1), 1), logic_error);
+    ASSERT_THROW(s.append(ArrayFi::Ones(3), 1), logic_error);
+}
+
+TEST(SparseStencil, isRealSymmetric)
+{
+    ArrayFi center = ArrayFi::Zero(2);
+    ArrayFi east = ArrayFi::Zero(2);
+    east[0] = 1;
+    ArrayFi west = -east;
+    ArrayFi north = ArrayFi::Zero(2);
+    north[1] = 1;
+
+    SparseStencil s;
+    s.append(center, 4);
+    s.append(east, -1);
+    s.append(west, -1);
+    EXPECT_TRUE(s.isRealSymmetric());
+
+    // the values of a repeated offset are summed
+    SparseStencil repeated = s;
+    repeated.append(east, -1);
+    EXPECT_FALSE(repeated.isRealSymmetric());
+    repeated.append(west, -1);
+    EXPECT_TRUE(repeated.isRealSymmetric());
+
+    SparseStencil one_sided = s;
+    one_sided.append(north, 1);
+    EXPECT_FALSE(one_sided.isRealSymmetric());
+
+    SparseStencil complex_valued;
+    complex_valued.append(center, complex<double>(1, 1));
+    EXPECT_FALSE(complex_valued.isRealSymmetric());
 }
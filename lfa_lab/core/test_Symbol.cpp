@@ -28,6 +28,7 @@
 #include "MathUtil.h"
 #include "StencilGallery.h"
 #include "BlockSb.h"
+#include "HpFilterSb.h"
 
 using namespace lfa;
 
@@ -57,6 +58,66 @@ TEST(Symbol, Iterator)
     EXPECT_LE( (sym.full() - M).norm(), 1e-12 );
 }
 
+TEST(Symbol, LinearIndexing)
+{
+    ArrayFi base_shape(2), row_shape(2), col_shape(2);
+    base_shape << 2, 3;
+    row_shape << 1, 2;
+    col_shape << 3, 1;
+    HarmonicClusters row_clusters(base_shape, row_shape);
+    HarmonicClusters col_clusters(base_shape, col_shape);
+
+    Symbol sym(row_clusters, col_clusters);
+
+    // the iterator walks the storage in order
+    int k = 0;
+    for (Symbol::iterator iter = sym.begin(); iter != sym.end(); ++iter)
+    {
+        EXPECT_EQ(&*iter, sym.matrix().data() + k);
+        EXPECT_EQ(iter.baseIndex(), sym.baseIndices().indexOf(iter.base()));
+        EXPECT_EQ(iter.rowIndex(),
+                  row_clusters.clusterIndices().indexOf(iter.row()));
+        EXPECT_EQ(iter.colIndex(),
+                  col_clusters.clusterIndices().indexOf(iter.col()));
+
+        *iter = complex<double>(k, 1);
+        EXPECT_EQ(sym.ref(iter.base(), iter.row(), iter.col()),
+                  complex<double>(k, 1));
+        k += 1;
+    }
+    EXPECT_EQ(k, sym.matrix().no_blocks() * sym.matrix().block_size());
+
+    NdArray<double> row_norms = sym.row_norms();
+    NdArray<double> col_norms = sym.col_norms();
+    NdRange bases = sym.baseIndices();
+    NdRange rows = row_clusters.clusterIndices();
+    NdRange cols = col_clusters.clusterIndices();
+    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+        MatrixXcd block = sym.fullCluster(*b);
+        for (int i = 0; i < int(rows.size()); ++i) {
+            ArrayFi g = row_clusters.globalIndex(*b, rows.coordOf(i));
+            EXPECT_NEAR(row_norms(g), block.row(i).norm(), 1e-12);
+        }
+        for (int j = 0; j < int(cols.size()); ++j) {
+            ArrayFi g = col_clusters.globalIndex(*b, cols.coordOf(j));
+            EXPECT_NEAR(col_norms(g), block.col(j).norm(), 1e-12);
+        }
+    }
+
+    // the fused kernel writes in the order of the global indices
+    VectorXd fused_rows(row_clusters.size());
+    VectorXd fused_cols(col_clusters.size());
+    sym.row_col_norms(fused_rows.data(), fused_cols.data());
+    NdRange row_global = row_clusters.globalIndices();
+    NdRange col_global = col_clusters.globalIndices();
+    for (int i = 0; i < int(row_global.size()); ++i) {
+        EXPECT_EQ(fused_rows[i], row_norms(row_global.coordOf(i)));
+    }
+    for (int j = 0; j < int(col_global.size()); ++j) {
+        EXPECT_EQ(fused_cols[j], col_norms(col_global.coordOf(j)));
+    }
+}
+
 class Poisson1dFixture : public testing::Test
 {
     public:
@@ -143,3 +204,275 @@ ArrayFd Fixture2d::theta(ArrayFi b)
 
 
 
+
+TEST(Symbol, StencilOnLattice)
+{
+    Grid grid(3, ArrayFd::Constant(3, 1.0 / 16));
+    ArrayFd base_freq(3);
+    base_freq << 0.01, 0.02, 0.03;
+    ArrayFi resolution(3);
+    resolution << 8, 4, 6;
+    SamplingProperties conf(resolution, base_freq);
+
+    // a 27-point stencil with distinct complex values
+    SparseStencil stencil;
+    NdRange offsets(ArrayFi::Constant(3, 3));
+    int k = 0;
+    for (NdRange::iterator p = offsets.begin(); p != offsets.end(); ++p) {
+        stencil.append(*p - 1, complex<double>(k, 1.0 / (k + 1)));
+        ++k;
+    }
+
+    FoStencil op(stencil, grid);
+
+    ArrayFi factor(3);
+    factor << 2, 1, 3;
+    DiscreteDomain domain(SplitFrequencyDomain(grid, factor), conf);
+    HarmonicClusters clusters = domain.harmonics();
+
+    Symbol sym = op.generateExpanded(conf, factor);
+    NdRange bases = clusters.baseIndices();
+    NdRange cluster_indices = clusters.clusterIndices();
+    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+        for (NdRange::iterator c = cluster_indices.begin();
+             c != cluster_indices.end(); ++c)
+        {
+            VectorFd freq = domain.frequency(*b, *c);
+            EXPECT_LE(std::abs(sym.ref(*b, *c, *c) - op.symbolAt(freq)),
+                      1e-10);
+        }
+    }
+}
+
+TEST(Symbol, StencilOnLatticeDimensions)
+{
+    // the separable evaluation is specialised for some dimensions
+    for (int d = 1; d <= 4; ++d) {
+        Grid grid(d, ArrayFd::Constant(d, 1.0 / 8));
+        ArrayFd base_freq = ArrayFd::Constant(d, 0.02);
+        ArrayFi resolution = ArrayFi::Constant(d, 4);
+        resolution[0] = 6;
+        SamplingProperties conf(resolution, base_freq);
+
+        SparseStencil stencil;
+        NdRange offsets(ArrayFi::Constant(d, 3));
+        int k = 0;
+        for (NdRange::iterator p = offsets.begin(); p != offsets.end(); ++p) {
+            stencil.append(*p - 1, complex<double>(k, 1.0 / (k + 1)));
+            ++k;
+        }
+
+        FoStencil op(stencil, grid);
+        DiscreteDomain domain(SplitFrequencyDomain(grid), conf);
+        VectorXcd values = op.symbolOnLatticeSeparable(domain);
+
+        NdRange lattice(domain.resolution());
+        for (int i = 0; i < int(lattice.size()); ++i) {
+            VectorFd freq = domain.frequency(lattice.coordOf(i));
+            EXPECT_LE(std::abs(values[i] - op.symbolAt(freq)), 1e-10);
+        }
+    }
+}
+
+TEST(Symbol, WideStencilFft)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 16));
+    ArrayFd base_freq(2);
+    base_freq << 0.05, 0.1;
+    ArrayFi resolution(2);
+    resolution << 12, 10;
+    SamplingProperties conf(resolution, base_freq);
+
+    // wider than the resolution, such that the offsets wrap around
+    SparseStencil stencil;
+    NdRange offsets(ArrayFi::Constant(2, 15));
+    int k = 0;
+    for (NdRange::iterator p = offsets.begin(); p != offsets.end(); ++p) {
+        stencil.append(*p - 7, complex<double>(cos(k), sin(2.0 * k)));
+        ++k;
+    }
+
+    FoStencil op(stencil, grid);
+    DiscreteDomain domain(SplitFrequencyDomain(grid), conf);
+
+    VectorXcd fft = op.symbolOnLatticeFft(domain);
+    VectorXcd separable = op.symbolOnLatticeSeparable(domain);
+    EXPECT_LE((fft - separable).norm(), 1e-9);
+
+    NdRange lattice(resolution);
+    for (NdRange::iterator g = lattice.begin(); g != lattice.end(); ++g) {
+        VectorFd freq = domain.frequency(*g);
+        EXPECT_LE(std::abs(fft[lattice.indexOf(*g)] - op.symbolAt(freq)),
+                  1e-9);
+    }
+}
+
+TEST(Symbol, StencilOnLatticeMethod)
+{
+    // full square stencils of the width 9 in 2D and 41 in 1D
+    SparseStencil square, line;
+    NdRange square_offsets(ArrayFi::Constant(2, 9));
+    for (NdRange::iterator p = square_offsets.begin();
+         p != square_offsets.end(); ++p) {
+        square.append(*p - 4, 1.0);
+    }
+    for (int k = -20; k <= 20; ++k) {
+        line.append(ArrayFi::Constant(1, k), 1.0);
+    }
+
+    // the FFT of a 2D lattice costs more than the separable evaluation of
+    // the 9x9 stencil, in particular for prime resolutions
+    FoStencil square_op(square, Grid(2, ArrayFd::Constant(2, 1.0 / 16)));
+    EXPECT_FALSE(square_op.preferFft(ArrayFi::Constant(2, 128)));
+    EXPECT_FALSE(square_op.preferFft(ArrayFi::Constant(2, 127)));
+    EXPECT_FALSE(square_op.preferFft(ArrayFi::Constant(2, 131)));
+
+    // a wide 1D stencil, unless the resolution is a large prime
+    FoStencil line_op(line, Grid(1, ArrayFd::Constant(1, 1.0 / 16)));
+    EXPECT_TRUE(line_op.preferFft(ArrayFi::Constant(1, 256)));
+    EXPECT_TRUE(line_op.preferFft(ArrayFi::Constant(1, 1000)));
+    EXPECT_FALSE(line_op.preferFft(ArrayFi::Constant(1, 4099)));
+}
+
+TEST(Symbol, BlockSbClusterDft)
+{
+    Grid grid(2, ArrayFd::Constant(2, 1.0 / 16));
+    ArrayFi period(2);
+    period << 2, 3;
+    ArrayFi resolution(2);
+    resolution << 8, 6;
+    SamplingProperties conf(resolution, grid);
+
+    // different scalar operators at every point of the period
+    ArrayFi center = ArrayFi::Zero(2);
+    ArrayFi east = ArrayFi::Zero(2);
+    east[0] = 1;
+    ArrayFi south = ArrayFi::Zero(2);
+    south[1] = -1;
+
+    NdRange pattern(period);
+    NdArray<Symbol> scalars(period);
+    for (NdRange::iterator p = pattern.begin(); p != pattern.end(); ++p) {
+        SparseStencil s;
+        s.append(center, 4.0 + pattern.indexOf(*p));
+        s.append(east, complex<double>(-1.0, p->sum()));
+        s.append(south, -1.0 - (*p)(1));
+        scalars(*p) = FoStencil(s, grid).generate(conf);
+    }
+
+    BlockSb sb(grid, period);
+    sb.scalarSymbols(scalars);
+    Symbol sym = sb.generate(conf);
+
+    // the definition: F^H G / n, with F(i,j) = exp(2 pi i i.j/period) and
+    // G(i,j) = s_i(g_j) F(i,j)
+    HarmonicClusters clusters = sym.outputClusters();
+    NdRange bases = clusters.baseIndices();
+    ArrayFi zero = ArrayFi::Zero(2);
+    int n = pattern.size();
+    for (NdRange::iterator b = bases.begin(); b != bases.end(); ++b) {
+        MatrixXcd F(n, n), G(n, n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                ArrayFi ci = pattern.coordOf(i);
+                ArrayFi cj = pattern.coordOf(j);
+                double arg = 2 * pi * (ci.cast<double>() * cj.cast<double>()
+                                       / period.cast<double>()).sum();
+                F(i, j) = exp(complex<double>(0, arg));
+                G(i, j) = scalars(ci).ref(clusters.globalIndex(*b, cj),
+                                          zero, zero) * F(i, j);
+            }
+        }
+        MatrixXcd expected = F.adjoint() * G / double(n);
+
+        EXPECT_LE((sym.fullCluster(*b) - expected).norm(), 1e-10);
+    }
+}
+
+TEST(Symbol, Structure)
+{
+    Grid fine(2, ArrayFd::Constant(2, 1.0 / 16));
+    Grid coarse = fine.coarse(ArrayFi::Constant(2, 2));
+    SamplingProperties conf(ArrayFi::Constant(2, 8), fine);
+
+    // a stencil couples no frequencies, its 1x1 blocks stay diagonal when
+    // the clusters are merged
+    FoStencil stencil(stencil_poisson2d(fine.step_size()), fine);
+    Symbol s = stencil.generate(conf);
+    EXPECT_EQ(BdMatrix::Diagonal, s.structure());
+    Symbol expanded = s.expand(ArrayFi::Constant(2, 2));
+    EXPECT_EQ(BdMatrix::Diagonal, expanded.structure());
+
+    // the symbol of a real symmetric stencil is real
+    EXPECT_TRUE(stencil.isRealSymmetric());
+    EXPECT_TRUE(s.isReal());
+    EXPECT_TRUE(expanded.isReal());
+    Symbol direct = stencil.generateExpanded(conf, ArrayFi::Constant(2, 2));
+    EXPECT_LE((expanded.full() - direct.full()).norm(), 1e-12);
+
+    Symbol hp = HpFilterSb(fine, coarse).generate(conf);
+    EXPECT_EQ(BdMatrix::Diagonal, hp.structure());
+
+    Symbol id = Symbol::Identity(hp.outputClusters(), hp.inputClusters());
+    EXPECT_EQ(BdMatrix::Identity, id.structure());
+    EXPECT_EQ(BdMatrix::Diagonal, (id + hp).structure());
+
+    // writing to a symbol drops the structure
+    expanded.ref(ArrayFi::Zero(2), ArrayFi::Zero(2), ArrayFi::Ones(2)) = 1.0;
+    EXPECT_EQ(BdMatrix::Dense, expanded.structure());
+    EXPECT_FALSE(expanded.isReal());
+
+    // the cosine sum of a real symmetric stencil agrees with the sum of
+    // the complex exponentials
+    SparseStencil poisson = stencil_poisson2d(fine.step_size());
+    VectorFd f = VectorFd::Zero(2);
+    f << 0.3, -1.7;
+    complex<double> expected = 0;
+    for (int k = 0; k < poisson.nonZeros(); ++k) {
+        VectorFd pos = VectorFd::Zero(2);
+        pos += (poisson[k].offset.cast<double>()
+                * fine.step_size()).matrix();
+        expected += poisson[k].value * exp(complex<double>(0, f.dot(pos)));
+    }
+    EXPECT_NEAR(abs(stencil.symbolAt(f) - expected), 0, 1e-10);
+}
+
+TEST(Symbol, WritingDropsStructure)
+{
+    ArrayFi base_shape(2), cluster_shape(2);
+    base_shape << 2, 3;
+    cluster_shape << 2, 1;
+    HarmonicClusters clusters(base_shape, cluster_shape);
+
+    // a new symbol is zero, the writes through the iterator and the
+    // storage have to drop that
+    Symbol a(clusters, clusters);
+    for (Symbol::iterator iter = a.begin(); iter != a.end(); ++iter) {
+        *iter = 1;
+    }
+    Symbol b(clusters, clusters);
+    b.matrix()(0, 0, 0) = 2;
+    Symbol c(clusters, clusters);
+    c.blockData(1)[1] = 3;
+
+    EXPECT_EQ(BdMatrix::Dense, a.structure());
+    EXPECT_EQ(BdMatrix::Dense, b.structure());
+    EXPECT_EQ(BdMatrix::Dense, c.structure());
+
+    const Symbol sum = a + b;
+    const Symbol product = a * b;
+    EXPECT_EQ(complex<double>(3), sum.matrix()(0, 0, 0));
+    EXPECT_EQ(complex<double>(2), product.matrix()(0, 0, 0));
+    EXPECT_LE((sum.full() - (a.full() + b.full())).norm(), 1e-14);
+    EXPECT_LE((product.full() - a.full() * b.full()).norm(), 1e-14);
+    EXPECT_LE(((c * a).full() - c.full() * a.full()).norm(), 1e-14);
+
+    // reading through the const overloads keeps the structure
+    const Symbol zero(clusters, clusters);
+    for (Symbol::const_iterator iter = zero.begin(); iter != zero.end();
+         ++iter) {
+        EXPECT_EQ(complex<double>(0), *iter);
+    }
+    EXPECT_EQ(complex<double>(0), zero.matrix()(0, 0, 0));
+    EXPECT_EQ(BdMatrix::Zero, zero.structure());
+}
@@ -19,7 +19,7 @@ from .core import *
 from .util import NdArray
 import numpy as np
 from abc import ABCMeta, abstractmethod
-from six import with_metaclass
+from six import with_metaclass, string_types
 from .util import indent
 
 __all__ = [
@@ -32,11 +32,25 @@ __all__ = [
     'FlatRestrictionNode',
     'ZeroNode',
     'HpFilterNode',
-    'SystemNode'
+    'SystemNode',
+    'Parameter'
 ]
 
 default_resolution = 32
 
+class Parameter(object):
+    """A named scalar, whose value can be varied without rebuilding the
+    operator (see :func:`Node.sweep`). Otherwise, it behaves like its
+    default value.
+    """
+
+    def __init__(self, name, value = 1.0):
+        self.name = name
+        self.value = value
+
+    def __repr__(self):
+        return 'Parameter({!r}, {!r})'.format(self.name, self.value)
+
 class Node(object):
     """This node represents general operators whose symbols can be computed.
 
@@ -62,16 +76,29 @@ class Node(object):
         return NodeMul(self, other)
 
     def __rmul__(self, other):
-        """Scalar multiplication of `self` and `other`."""
+        """Scalar multiplication of `self` and `other`. The scalar may be a
+        :class:`Parameter`."""
+        if isinstance(other, Parameter):
+            return NodeParameterMul(other, self)
         return NodeScalarMul(other, self)
 
     def __pow__(self, p):
-        """Compute the power of an operator."""
+        """Compute the power of an operator. The symbol is computed by
+        repeated squaring."""
         assert(p >= 1)
-        aux = self
-        for i in range(1, p):
-            aux = aux * self
-        return aux
+        if p == 1:
+            return self
+        return NodePower(self, p)
+
+    def polynomial(self, coefficients):
+        """The polynomial :math:`\\sum_k c_k A^k` of the operator
+        :math:`A`, evaluated by the Horner scheme.
+
+        :param coefficients: The coefficients :math:`c_k`, starting with the
+            constant term.
+        :rtype: Node
+        """
+        return NodePolynomial(coefficients, self)
 
     def inverse(self):
         """The inverse of the operator.
@@ -137,16 +164,10 @@ class Node(object):
         visit(self)
         self._unmark_all()
 
-    def symbol(self, desired_resolution = None, base_frequency = None):
-        """The symbol of the operator.
-
-        :rtype: Symbol
-        """
+    def _sampling_properties(self, desired_resolution, base_frequency):
+        """The sampling used to compute the symbol."""
         global default_resolution
 
-        # ensure that we are not deleted
-        self.inc_ref()
-
         d = self.properties.dimension()
         if desired_resolution is None:
             desired_resolution = np.ones(d) * default_resolution
@@ -156,10 +177,25 @@ class Node(object):
 
         if base_frequency is None:
             # compute default base_frequency
-            conf = SamplingProperties(resolution, self.properties.inputGrid())
+            return SamplingProperties(resolution, self.properties.inputGrid())
         else:
             base_frequency = tuple(base_frequency)
-            conf = SamplingProperties(resolution, base_frequency)
+            return SamplingProperties(resolution, base_frequency)
+
+    def symbol(self, desired_resolution = None, base_frequency = None):
+        """The symbol of the operator.
+
+        :rtype: Symbol
+        """
+        conf = self._sampling_properties(desired_resolution, base_frequency)
+
+        # let the core evaluate the whole graph, if it can
+        expression = self._native_expression()
+        if expression is not None:
+            return expression.symbol(conf)
+
+        # ensure that we are not deleted
+        self.inc_ref()
 
         # set the configuration for all nodes in the DAG
         def set_configuration(n):
@@ -185,6 +221,78 @@ class Node(object):
 
         return symbol
 
+    def sweep(self, name, values,
+              desired_resolution = None, base_frequency = None):
+        """The symbols of the operator for every value of the parameter
+        `name`. The parts of the operator that do not depend on the
+        parameter are computed only once.
+
+        :param values: The values of the parameter. If `name` is a list of
+            names, every value is a tuple with one entry per name.
+        :rtype: list of Symbol
+        """
+        conf = self._sampling_properties(desired_resolution, base_frequency)
+        sweep = ParameterSweep(self.expression(), conf)
+
+        names = [name] if isinstance(name, string_types) else list(name)
+        symbols = []
+        for value in values:
+            point = [value] if isinstance(name, string_types) else value
+            for n, v in zip(names, point):
+                sweep.set(n, v)
+            symbols.append(sweep.symbol())
+        return symbols
+
+    def lazy_symbol(self, desired_resolution = None, base_frequency = None):
+        """The symbol of the operator, evaluated one frequency cluster at a
+        time.
+
+        The symbol is never stored as a whole. Hence, the spectral radius,
+        the spectral norm, and the eigenvalues can be computed for
+        resolutions whose symbol would not fit into memory. Systems are not
+        supported. If the operator has real coefficients, the clusters come
+        in complex conjugate pairs and only one cluster of every pair is
+        evaluated.
+
+        :rtype: LazySymbol
+        """
+        conf = self._sampling_properties(desired_resolution, base_frequency)
+        return LazySymbol(self.expression(), conf)
+
+    def expression(self):
+        """The operator as an expression of the C++ core.
+
+        :rtype: Expression
+        """
+        if hasattr(self, '_expression'):
+            return self._expression
+        expression = self.compute_expression()
+        # the current values of the parameters are baked into the
+        # expression, hence it must be rebuilt after a value changed
+        if not self._depends_on_parameter():
+            self._expression = expression
+        return expression
+
+    def _depends_on_parameter(self):
+        """Whether a :class:`Parameter` occurs in the operator."""
+        if not hasattr(self, '_has_parameter'):
+            self._has_parameter = any(d._depends_on_parameter()
+                                      for d in self.dependencies)
+        return self._has_parameter
+
+    def _native_expression(self):
+        """The expression of the operator, or None if the operator cannot be
+        evaluated by the core."""
+        try:
+            return self.expression()
+        except NotImplementedError:
+            return None
+
+    def compute_expression(self):
+        raise NotImplementedError(
+                'The operator cannot be evaluated lazily: {}'
+                .format(type(self).__name__))
+
     def matching_identity(self):
         """An identity operator that has the same output and input grid as the
            current one."""
@@ -236,6 +344,9 @@ class IdentityNode(Node, Splitable):
     def compute_symbol(self):
         self._symbol = Symbol.Identity(self.grid, self.configuration)
 
+    def compute_expression(self):
+        return Expression.Identity(self.grid)
+
     def matching_identity(self):
         return self
 
@@ -267,6 +378,9 @@ class ZeroNode(Node, Splitable):
     def compute_symbol(self):
         self._symbol = Symbol.Zero(self.grid, self.configuration)
 
+    def compute_expression(self):
+        return Expression.Zero(self.grid)
+
     def matching_zero(self):
         return self
 
@@ -296,6 +410,9 @@ class GeneratorNode(Node):
     def compute_symbol(self):
         self._symbol = self._generator.generate(self.configuration)
 
+    def compute_expression(self):
+        return Expression(self._generator)
+
 class StencilNode(GeneratorNode):
     """An Operator given by a stencil.
 
@@ -406,6 +523,9 @@ class NodeAdd(Node):
     def compute_symbol(self):
         self._symbol = self._a._symbol + self._b._symbol
 
+    def compute_expression(self):
+        return self._a.expression() + self._b.expression()
+
     def matching_zero(self):
         return self._a.matching_zero()
 
@@ -428,6 +548,9 @@ class NodeMul(Node):
     def compute_symbol(self):
         self._symbol = self._a._symbol * self._b._symbol
 
+    def compute_expression(self):
+        return self._a.expression() * self._b.expression()
+
     def matching_zero(self):
         return self._a.matching_zero() * self._b.matching_zero()
 
@@ -436,6 +559,69 @@ class NodeMul(Node):
                  .format(indent(repr(self._a), '  '),
                          indent(repr(self._b), '  '))
 
+class NodePower(Node):
+
+    def __init__(self, a, p):
+        super(NodePower, self).__init__()
+
+        self._a = a
+        self._p = p
+        self.dependencies = [a]
+        self.properties = a.properties * a.properties
+
+    def compute_symbol(self):
+        # repeated squaring
+        base = self._a._symbol
+        result = None
+        p = self._p
+        while p > 0:
+            if p % 2 == 1:
+                result = base if result is None else result * base
+            p //= 2
+            if p > 0:
+                base = base * base
+        self._symbol = result
+
+    def compute_expression(self):
+        return self._a.expression().power(self._p)
+
+    def matching_zero(self):
+        return self._a.matching_zero()
+
+    def __repr__(self):
+        return '(**\n{}\n  {})' \
+                 .format(indent(repr(self._a), '  '), self._p)
+
+class NodePolynomial(Node):
+
+    def __init__(self, coefficients, a):
+        super(NodePolynomial, self).__init__()
+
+        self._coefficients = list(coefficients)
+        self._a = a
+        self._identity = a.matching_identity()
+        self.dependencies = [a, self._identity]
+        self.properties = a.properties * a.properties
+
+    def compute_symbol(self):
+        # Horner scheme
+        a = self._a._symbol
+        identity = self._identity._symbol
+        result = 0 * identity
+        for c in reversed(self._coefficients):
+            result = result * a + c * identity
+        self._symbol = result
+
+    def compute_expression(self):
+        return self._a.expression().polynomial(self._coefficients)
+
+    def matching_zero(self):
+        return self._a.matching_zero()
+
+    def __repr__(self):
+        return '(poly {}\n{})' \
+                 .format(self._coefficients, indent(repr(self._a), '  '))
+
 class NodeScalarMul(Node):
 
     def __init__(self, a, b):
@@ -449,6 +635,9 @@ class NodeScalarMul(Node):
     def compute_symbol(self):
         self._symbol = self._a * self._b._symbol
 
+    def compute_expression(self):
+        return self._a * self._b.expression()
+
     def matching_zero(self):
         return self._b.matching_zero()
 
@@ -457,6 +646,34 @@ class NodeScalarMul(Node):
                 .format(indent(repr(self._a), '  '),
                         indent(repr(self._b), '  '))
 
+class NodeParameterMul(Node):
+
+    def __init__(self, parameter, b):
+        super(NodeParameterMul, self).__init__()
+
+        self._parameter = parameter
+        self._b = b
+        self.dependencies = [b]
+        self.properties = b.properties
+
+    def compute_symbol(self):
+        self._symbol = self._parameter.value * self._b._symbol
+
+    def _depends_on_parameter(self):
+        return True
+
+    def compute_expression(self):
+        return self._b.expression().parameterized(self._parameter.name,
+                                                  self._parameter.value)
+
+    def matching_zero(self):
+        return self._b.matching_zero()
+
+    def __repr__(self):
+        return '(*\n{}\n{})' \
+                .format(indent(repr(self._parameter), '  '),
+                        indent(repr(self._b), '  '))
+
 class NodeInverse(Node):
 
     def __init__(self, other):
@@ -469,6 +686,9 @@ class NodeInverse(Node):
     def compute_symbol(self):
         self._symbol = self._other._symbol.inverse()
 
+    def compute_expression(self):
+        return self._other.expression().inverse()
+
     def matching_zero(self):
         return self._other.matching_zero()
 
@@ -486,6 +706,9 @@ class NodeAdjoint(Node):
     def compute_symbol(self):
         self._symbol = self._other._symbol.adjoint()
 
+    def compute_expression(self):
+        return self._other.expression().adjoint()
+
     def matching_zero(self):
         return NodeAdjoint(self._other.matching_zero())
 
@@ -540,6 +763,13 @@ class BlockNode(Node):
         self._generator.scalarSymbols(symbols)
         self._symbol = self._generator.generate(self.configuration)
 
+    def compute_expression(self):
+        scalars = ExpressionNdArray(self._scalars.shape)
+        for i in scalars.indices():
+            scalars[i] = self._scalars[i].expression()
+
+        return Expression.Block(scalars)
+
     def __repr__(self):
         return '(block\n{})' \
                 .format(indent(repr(self._scalars), '  '))
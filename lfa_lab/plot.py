@@ -105,9 +105,9 @@ def plot_2d(sym, **kwargs):
 
     norm_type = options['norm_type']
     if norm_type == 'rows' or norm_type == 'output':
-        M = np.abs(smpl.row_norms_2d())
+        M = smpl.row_norms_array()
     elif norm_type == 'columns' or norm_type == 'input':
-        M = np.abs(smpl.col_norms_2d())
+        M = smpl.col_norms_array()
     else:
         raise Exception('Unknown norm type "{}".'.format(norm_type))
 
@@ -143,9 +143,9 @@ def plot_1d(op, **kwargs):
 
     smpl = op.symbol()
     if options['norm_type'] == 'rows' or options['norm_type'] == 'output':
-        v = np.abs(smpl.row_norms_1d())
+        v = smpl.row_norms_array()
     elif options['norm_type'] == 'columns' or options['norm_type'] == 'input':
-        v = np.abs(smpl.col_norms_1d())
+        v = smpl.col_norms_array()
     else:
         raise Exception('Unknown norm type "{}".'.format(options['norm_type']))
 
@@ -25,6 +25,7 @@ from smoother_test import *
 from operator_test import *
 from stencil_test import *
 from analysis_test import *
+from symbol_test import *
 
 if __name__ == '__main__':
     unittest.main()
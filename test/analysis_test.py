@@ -18,6 +18,39 @@ class AnalysisTest(TestCase):
 
         self.assertLess(abs(smoothing_factor(J) - 3.0/5), 1e-2)
 
+    def test_lazy_two_grid(self):
+        fine = Grid(2, [1.0/32, 1.0/32])
+        coarse = fine.coarse((2,2))
+        L = gallery.poisson_2d(fine)
+        Lc = gallery.poisson_2d(coarse)
+        S = smoother.jacobi(L, 4.0/5.0)
+        P = gallery.ml_interpolation(fine, coarse)
+        R = gallery.fw_restriction(fine, coarse)
+        E = S * coarse_grid_correction(L, Lc, P, R) * S
+
+        symbol = E.symbol()
+        lazy = E.lazy_symbol()
+        self.assertAlmostEqual(symbol.spectral_radius(),
+                               lazy.spectral_radius())
+        self.assertAlmostEqual(symbol.spectral_norm(),
+                               lazy.spectral_norm())
+
+    def test_changed_parameter(self):
+        fine = Grid(2, [1.0/32, 1.0/32])
+        L = gallery.poisson_2d(fine)
+        omega = Parameter('omega', 1.0)
+        A = L * omega
+
+        radius = A.symbol().spectral_radius()
+        A.lazy_symbol().spectral_radius()
+
+        # the new value must be used, even after the operator was sampled
+        omega.value = 0.5
+        self.assertAlmostEqual(A.symbol().spectral_radius(), 0.5 * radius)
+        self.assertAlmostEqual(A.lazy_symbol().spectral_radius(),
+                               0.5 * radius)
+        self.assertAlmostEqual((L + A).symbol().spectral_radius(),
+                               1.5 * radius)
 
 if __name__ == '__main__':
     main()
@@ -0,0 +1,74 @@
+# LFA Lab - Library to simplify local Fourier analysis.
+# Copyright (C) 2018  Hannah Rittich
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+from lfa_lab import *
+
+import unittest
+from unittest import TestCase
+
+import numpy as np
+
+class SymbolTest(TestCase):
+
+    def setUp(self):
+        fine = Grid(2, [1.0/8, 1.0/8])
+        coarse = fine.coarse((2,2))
+        L = gallery.poisson_2d(fine)
+        Lc = gallery.poisson_2d(coarse)
+        P = gallery.ml_interpolation(fine, coarse)
+        R = gallery.fw_restriction(fine, coarse)
+        E = coarse_grid_correction(L, Lc, P, R)
+        self.symbol = E.symbol()
+
+    def test_blocks(self):
+        matrix = self.symbol.matrix()
+        blocks = self.symbol.blocks()
+
+        rows = matrix.block_rows()
+        cols = matrix.block_cols()
+        self.assertEqual((matrix.no_blocks(), rows, cols), blocks.shape)
+        self.assertEqual(4, rows)
+        self.assertEqual(4, cols)
+
+        # column-major blocks, stored one after another
+        item = blocks.itemsize
+        self.assertEqual((rows * cols * item, item, rows * item),
+                         blocks.strides)
+
+        for i in range(matrix.no_blocks()):
+            self.assertTrue(np.allclose(matrix.block(i), blocks[i]))
+
+    def test_blocks_keep_symbol_alive(self):
+        blocks = self.symbol.blocks()
+        expected = blocks.copy()
+
+        del self.symbol
+        self.assertTrue(np.array_equal(expected, blocks))
+
+    def test_blocks_read_only(self):
+        blocks = self.symbol.blocks()
+
+        self.assertFalse(blocks.flags.writeable)
+        with self.assertRaises(ValueError):
+            blocks[0, 0, 0] = 1.0
+
+    def test_blocks_only_entry_point(self):
+        # the view helper takes an arbitrary owner, hence, it is private
+        self.assertFalse(hasattr(self.symbol, 'blocks_view'))
+
+if __name__ == '__main__':
+    unittest.main()